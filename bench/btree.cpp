@@ -0,0 +1,182 @@
+#include "../btree.cpp"
+#include "../rbtree.cpp"
+
+#include <chrono>
+
+// btree against rbtree and std::set on the same keys and queries.
+// std::set has no order statistics, so it skips count_lt and get.
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+vector<uint32_t> keys, queries;
+
+template <typename T>
+static void run_btree(const char *name)
+{
+	T tree;
+	uint64_t check = 0;
+	double insert = 0, find = 0, rank = 0, select = 0, erase = 0;
+	auto start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.insert(key);
+	}
+
+	insert = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		auto position = tree.find_gte(query);
+
+		if (position)
+		{
+			check += tree.key(position);
+		}
+	}
+
+	find = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		check += tree.count_lt(query);
+	}
+
+	rank = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		check += tree.key(tree.get(query % tree.size()));
+	}
+
+	select = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.erase(key);
+	}
+
+	erase = elapsed(start);
+
+	cout << format("{:<12} insert {:.1f} find_gte {:.1f} count_lt {:.1f} get {:.1f} erase {:.1f} ms ({})\n", name, insert, find, rank,
+				   select, erase, check);
+}
+
+static void run_rbtree()
+{
+	ordered_set<uint32_t> tree;
+	uint64_t check = 0;
+	double insert = 0, find = 0, rank = 0, select = 0, erase = 0;
+	auto start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.insert(key);
+	}
+
+	insert = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		auto node = tree.find_gte(query);
+
+		if (node)
+		{
+			check += node->key;
+		}
+	}
+
+	find = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		check += tree.count_lt(query);
+	}
+
+	rank = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		check += tree.get(query % tree.size())->key;
+	}
+
+	select = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.erase(key);
+	}
+
+	erase = elapsed(start);
+
+	cout << format("{:<12} insert {:.1f} find_gte {:.1f} count_lt {:.1f} get {:.1f} erase {:.1f} ms ({})\n", "rbtree", insert, find, rank,
+				   select, erase, check);
+}
+
+static void run_set()
+{
+	set<uint32_t> tree;
+	uint64_t check = 0;
+	double insert = 0, find = 0, erase = 0;
+	auto start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.insert(key);
+	}
+
+	insert = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t query : queries)
+	{
+		auto it = tree.lower_bound(query);
+
+		if (it != tree.end())
+		{
+			check += *it;
+		}
+	}
+
+	find = elapsed(start);
+	start = chrono::steady_clock::now();
+
+	for (uint32_t key : keys)
+	{
+		tree.erase(key);
+	}
+
+	erase = elapsed(start);
+
+	cout << format("{:<12} insert {:.1f} find_gte {:.1f} erase {:.1f} ms ({})\n", "std::set", insert, find, erase, check);
+}
+
+int main()
+{
+	uint32_t n = 0, q = 0;
+
+	IN(n);
+	keys.resize(n);
+	IN(keys, q);
+	queries.resize(q);
+	IN(queries);
+
+	run_set();
+	run_rbtree();
+	run_btree<btree<uint32_t, void, void, false, 16>>("btree B=16");
+	run_btree<btree<uint32_t, void, void, false, 32>>("btree B=32");
+	run_btree<btree<uint32_t, void, void, false, 64>>("btree B=64");
+
+	return 0;
+}
@@ -0,0 +1,11 @@
+import random
+
+# python btree.py > btree.in && python ../run.py -o -r btree
+
+N = 1000000
+Q = 1000000
+
+print(N)
+print(' '.join(str(random.randrange(2**31)) for _ in range(N)))
+print(Q)
+print(' '.join(str(random.randrange(2**31)) for _ in range(Q)))
@@ -0,0 +1,53 @@
+#include "../graph.cpp"
+
+#include <chrono>
+
+// Dinic (maxflow) against highest-label push-relabel on the same networks
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	uint32_t t = 0;
+
+	IN(t);
+
+	while (t--)
+	{
+		uint32_t n = 0, m = 0, source = 0, sink = 0;
+		string name;
+
+		IN(name, n, m, source, sink);
+
+		flow_graph graph(n);
+
+		for (uint32_t i = 0; i < m; ++i)
+		{
+			uint32_t u = 0, v = 0;
+			int64_t capacity = 0;
+
+			IN(u, v, capacity);
+			graph.add_edge(u - 1, v - 1, capacity);
+		}
+
+		graph.build();
+
+		auto start = chrono::steady_clock::now();
+		int64_t dinic = maxflow(graph, source - 1, sink - 1);
+		double first = elapsed(start);
+
+		graph.reset();
+
+		start = chrono::steady_clock::now();
+		int64_t relabel = push_relabel(graph, source - 1, sink - 1);
+		double second = elapsed(start);
+
+		cout << format("{}: {} vertices, {} edges, dinic {:.1f} ms, push_relabel {:.1f} ms, flow {} {}\n", name, n, m, first, second,
+					   dinic, dinic == relabel ? "match" : "MISMATCH");
+	}
+
+	return 0;
+}
@@ -0,0 +1,62 @@
+import random
+
+# python flow.py > flow.in && python ../run.py -o -r flow
+
+HALF = 2000
+DENSITY = 4
+WIDTH = 600
+HEIGHT = 600
+
+
+# Source -> left, left -> right with about 1 / DENSITY of all pairs, right -> sink
+def generate_bipartite():
+    n = HALF * 2 + 2
+    s = n - 1
+    t = n
+    edges = []
+
+    for i in range(1, HALF + 1):
+        edges.append((s, i, random.randint(500, 1499)))
+        edges.append((HALF + i, t, random.randint(500, 1499)))
+
+    for i in range(1, HALF + 1):
+        for j in range(1, HALF + 1):
+            if random.randrange(DENSITY) == 0:
+                edges.append((i, HALF + j, random.randint(1, 10)))
+
+    return ("bipartite", n, s, t, edges)
+
+
+# Both directions between grid neighbours, source feeds the left column and the right column drains to sink
+def generate_grid():
+    n = WIDTH * HEIGHT + 2
+    s = n - 1
+    t = n
+    edges = []
+
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            v = y * WIDTH + x + 1
+
+            if x + 1 < WIDTH:
+                edges.append((v, v + 1, random.randrange(100)))
+                edges.append((v + 1, v, random.randrange(100)))
+
+            if y + 1 < HEIGHT:
+                edges.append((v, v + WIDTH, random.randrange(100)))
+                edges.append((v + WIDTH, v, random.randrange(100)))
+
+    for y in range(HEIGHT):
+        edges.append((s, y * WIDTH + 1, 1000))
+        edges.append((y * WIDTH + WIDTH, t, 1000))
+
+    return ("grid", n, s, t, edges)
+
+
+instances = [generate_bipartite(), generate_grid()]
+
+print(len(instances))
+
+for name, n, s, t, edges in instances:
+    print(name, n, len(edges), s, t)
+    print('\n'.join(f"{u} {v} {c}" for u, v, c in edges))
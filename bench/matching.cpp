@@ -0,0 +1,72 @@
+#include "../graph.cpp"
+
+#include <chrono>
+
+// Hopcroft-Karp against Dinic on a unit capacity network over the same bipartite graph
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	uint32_t t = 0;
+
+	IN(t);
+
+	while (t--)
+	{
+		uint32_t left = 0, right = 0, m = 0;
+
+		IN(left, right, m);
+
+		uint32_t n = left + right;
+		csr_undirected_graph graph(n, m);
+		flow_graph network(n + 2);
+		vector<uint8_t> side(n, 0);
+
+		// Left vertices come first
+		fill(side.begin(), side.begin() + left, 1);
+
+		graph.read_edges();
+		graph.build();
+
+		for (const auto &edge : graph.edges)
+		{
+			network.add_edge(edge.source, edge.destination, 1);
+		}
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			if (side[i])
+			{
+				network.add_edge(n, i, 1);
+			}
+			else
+			{
+				network.add_edge(i, n + 1, 1);
+			}
+		}
+
+		network.build();
+
+		auto start = chrono::steady_clock::now();
+		auto [size, mate] = hopcroft_karp(graph, side);
+		double matching = elapsed(start);
+
+		start = chrono::steady_clock::now();
+		vector<uint8_t> cover = vertex_cover(graph, side, mate);
+		double konig = elapsed(start);
+		uint32_t covered = count(cover.begin(), cover.end(), 1);
+
+		start = chrono::steady_clock::now();
+		int64_t flow = maxflow(network, n, n + 1);
+		double dinic = elapsed(start);
+
+		cout << format("{} x {}, {} edges: hopcroft_karp {:.1f} ms, vertex_cover {:.1f} ms, dinic {:.1f} ms, matching {} {}\n", left, right, m,
+					   matching, konig, dinic, size, size == flow && size == covered ? "match" : "MISMATCH");
+	}
+
+	return 0;
+}
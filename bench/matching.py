@@ -0,0 +1,15 @@
+import random
+
+# python matching.py > matching.in && python ../run.py -o -r matching
+
+LEFT = 100000
+RIGHT = 100000
+DEGREES = [2, 3, 5]
+
+print(len(DEGREES))
+
+for degree in DEGREES:
+    m = LEFT * degree
+
+    print(LEFT, RIGHT, m)
+    print('\n'.join(f"{random.randint(1, LEFT)} {LEFT + random.randint(1, RIGHT)}" for _ in range(m)))
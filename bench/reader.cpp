@@ -0,0 +1,78 @@
+#include "../cp.h"
+
+#include <chrono>
+
+#include <unistd.h>
+
+// Compares IN() against the operator>> path on the same input.
+// stdin must be a regular file, run.py redirects one from reader.in.
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	ios::sync_with_stdio(false);
+	cin.tie(nullptr);
+
+	uint32_t n = 0;
+	uint64_t integers = 0;
+	double floats = 0;
+
+	// operator>>
+	{
+		auto start = chrono::steady_clock::now();
+
+		cin >> n;
+
+		vector<int64_t> a(n);
+		vector<double> b(n);
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			cin >> a[i];
+		}
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			cin >> b[i];
+		}
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			integers += a[i];
+			floats += b[i];
+		}
+
+		cout << format("cin:  {:.1f} ms (sum {} {:.3f})\n", elapsed(start), integers, floats);
+	}
+
+	// The fast reader maps the file, so only the fread fallback needs the offset reset
+	lseek(0, 0, SEEK_SET);
+	integers = 0;
+	floats = 0;
+
+	// IN()
+	{
+		auto start = chrono::steady_clock::now();
+
+		IN(n);
+
+		vector<int64_t> a(n);
+		vector<double> b(n);
+
+		IN(a, b);
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			integers += a[i];
+			floats += b[i];
+		}
+
+		cout << format("IN(): {:.1f} ms (sum {} {:.3f})\n", elapsed(start), integers, floats);
+	}
+
+	return 0;
+}
@@ -0,0 +1,9 @@
+import random
+
+# python reader.py > reader.in && python ../run.py -o -r reader
+
+N = 1000000
+
+print(N)
+print(' '.join(str(random.randint(-10**18, 10**18)) for _ in range(N)))
+print(' '.join(f"{random.uniform(-1e9, 1e9):.6f}" for _ in range(N)))
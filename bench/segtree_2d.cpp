@@ -0,0 +1,99 @@
+#include "../segtree.cpp"
+#include "../sums.cpp"
+
+#include <chrono>
+
+// segment_tree_2d against prefix_sums_2d and a merge_sort_tree over the flattened grid
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	uint32_t n = 0, q = 0;
+	int64_t check = 0;
+
+	IN(n);
+
+	vector<vector<int64_t>> grid(n, vector<int64_t>(n));
+	IN(grid, q);
+
+	vector<array<uint32_t, 4>> queries(q);
+	vector<array<uint32_t, 3>> updates(q);
+	IN(queries, updates);
+
+	{
+		auto start = chrono::steady_clock::now();
+		prefix_sums_2d<int64_t, op_add<int64_t>> sums(grid);
+		double build = elapsed(start);
+
+		start = chrono::steady_clock::now();
+
+		for (const auto &[top, left, bottom, right] : queries)
+		{
+			check += sums.sum(top, left, bottom, right);
+		}
+
+		cout << format("prefix_sums_2d:  build {:.1f} ms, {} queries {:.1f} ms\n", build, q, elapsed(start));
+	}
+
+	{
+		auto start = chrono::steady_clock::now();
+		segment_tree_2d<int64_t, op_add<int64_t>> tree(grid);
+		double build = elapsed(start);
+
+		start = chrono::steady_clock::now();
+
+		for (const auto &[top, left, bottom, right] : queries)
+		{
+			check -= tree.query(top, left, bottom, right);
+		}
+
+		double query = elapsed(start);
+		start = chrono::steady_clock::now();
+
+		for (const auto &[x, y, value] : updates)
+		{
+			tree.update(x, y, value);
+		}
+
+		cout << format("segment_tree_2d: build {:.1f} ms, {} queries {:.1f} ms, {} updates {:.1f} ms\n", build, q, query, q,
+					   elapsed(start));
+	}
+
+	// One 1D query per row of the rectangle, so only a slice of the queries is run
+	{
+		uint32_t count = MIN(q, 1000u);
+		vector<uint64_t> flat;
+
+		for (const auto &row : grid)
+		{
+			flat.insert(flat.end(), row.begin(), row.end());
+		}
+
+		auto start = chrono::steady_clock::now();
+		merge_sort_tree tree(flat);
+		double build = elapsed(start);
+
+		start = chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const auto &[top, left, bottom, right] = queries[i];
+
+			for (uint32_t row = top; row <= bottom; ++row)
+			{
+				tree.query((row * n) + left, (row * n) + right, 0);
+			}
+		}
+
+		cout << format("merge_sort_tree: build {:.1f} ms, {} queries {:.1f} ms\n", build, count, elapsed(start));
+	}
+
+	// Zero when prefix_sums_2d and segment_tree_2d agree
+	cout << format("check {}\n", check);
+
+	return 0;
+}
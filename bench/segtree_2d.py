@@ -0,0 +1,27 @@
+import random
+
+# python segtree_2d.py > segtree_2d.in && python ../run.py -o -r segtree_2d
+
+N = 2000
+Q = 200000
+
+
+def generate_query():
+    top, bottom = sorted(random.randrange(N) for _ in range(2))
+    left, right = sorted(random.randrange(N) for _ in range(2))
+
+    return f"{top} {left} {bottom} {right}"
+
+
+print(N)
+
+for _ in range(N):
+    print(' '.join(str(random.randint(0, 999)) for _ in range(N)))
+
+print(Q)
+
+for _ in range(Q):
+    print(generate_query())
+
+for _ in range(Q):
+    print(random.randrange(N), random.randrange(N), random.randint(0, 999))
@@ -0,0 +1,1143 @@
+#include "cp.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+template <typename KEY, typename VALUE = void, typename PRIORITY = void, bool DUPLICATES = false, uint32_t B = 32>
+struct btree
+{
+	static_assert(B >= 8 && B % 8 == 0, "node width must be a multiple of 8");
+
+	using key_type = KEY;
+	using value_type = VALUE;
+	using priority_type = PRIORITY;
+
+	// Variable definitions
+	// key -> key in set or map
+	// value -> value associated with key
+	// priority -> augmented value of a key derived from value or key
+	// current -> combined augmented value of a child subtree
+	// size -> number of keys in a child subtree
+	// count -> number of keys in a leaf, number of children in an inner node
+	// parent -> index of parent inner node
+	// prev, next -> neighbouring leaves in order
+	//
+	// Keys live only in the leaves, inner nodes keep separators where
+	// max(child i) <= keys[i] <= min(child i + 1). Index 0 is null for both node kinds.
+
+	// Placeholder so that void values and priorities take no space
+	struct btempty
+	{
+	};
+
+	template <typename TYPE>
+	using btarray = conditional_t<is_same_v<TYPE, void>, btempty, array<conditional_t<is_same_v<TYPE, void>, uint8_t, TYPE>, B>>;
+
+	struct btleaf
+	{
+		uint32_t count = 0;
+		uint32_t parent = 0;
+		uint32_t prev = 0, next = 0;
+
+		key_type keys[B] = {};
+		[[no_unique_address]] btarray<VALUE> values = {};
+		[[no_unique_address]] btarray<PRIORITY> priority = {};
+	};
+
+	struct btinner
+	{
+		uint32_t count = 0;
+		uint32_t parent = 0;
+
+		key_type keys[B] = {};
+		uint32_t children[B] = {};
+		uint32_t sizes[B] = {};
+		[[no_unique_address]] btarray<PRIORITY> current = {};
+	};
+
+	// Location of a key, invalidated by any insert or erase
+	struct position
+	{
+		uint32_t leaf = 0, slot = 0;
+
+		explicit operator bool() const
+		{
+			return this->leaf != 0;
+		}
+	};
+
+	vector<btleaf> _leaves;
+	vector<btinner> _inners;
+	vector<uint32_t> _free_leaves; // leaves that can be reused
+	vector<uint32_t> _free_inners; // inner nodes that can be reused
+
+	uint32_t _root;   // root of tree
+	uint32_t _height; // number of inner levels, the root is a leaf when 0
+	uint32_t _count;  // number of keys in tree
+
+	btree()
+	{
+		this->_leaves.resize(1);
+		this->_inners.resize(1);
+
+		this->_root = 0;
+		this->_height = 0;
+		this->_count = 0;
+	}
+
+	// Number of the first count keys lesser than key, or not greater than key when INCLUSIVE.
+	// keys must be sorted, reads are rounded up to the vector width but stay inside the node.
+	template <bool INCLUSIVE>
+	static uint32_t _rank(const key_type *keys, uint32_t count, const key_type &key)
+	{
+		uint32_t result = 0;
+
+#if defined(__AVX2__)
+		if constexpr (integral<key_type> && sizeof(key_type) == 4)
+		{
+			// Flip the sign bit so unsigned keys compare as signed
+			const __m256i sign = _mm256_set1_epi32(is_signed_v<key_type> ? 0 : INT32_MIN);
+			const __m256i target = _mm256_xor_si256(_mm256_set1_epi32(key), sign);
+
+			for (uint32_t i = 0; i < count; i += 8)
+			{
+				__m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), sign);
+				uint32_t mask = INCLUSIVE ? ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(block, target)))
+										  : _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(target, block)));
+				uint32_t lanes = MIN(count - i, 8u);
+
+				mask &= (1u << lanes) - 1;
+				result += __builtin_popcount(mask);
+
+				if (mask != (1u << lanes) - 1)
+				{
+					break;
+				}
+			}
+
+			return result;
+		}
+
+		if constexpr (integral<key_type> && sizeof(key_type) == 8)
+		{
+			const __m256i sign = _mm256_set1_epi64x(is_signed_v<key_type> ? 0 : INT64_MIN);
+			const __m256i target = _mm256_xor_si256(_mm256_set1_epi64x(key), sign);
+
+			for (uint32_t i = 0; i < count; i += 4)
+			{
+				__m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), sign);
+				uint32_t mask = INCLUSIVE ? ~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(block, target)))
+										  : _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target, block)));
+				uint32_t lanes = MIN(count - i, 4u);
+
+				mask &= (1u << lanes) - 1;
+				result += __builtin_popcount(mask);
+
+				if (mask != (1u << lanes) - 1)
+				{
+					break;
+				}
+			}
+
+			return result;
+		}
+#elif defined(__SSE2__)
+		if constexpr (integral<key_type> && sizeof(key_type) == 4)
+		{
+			const __m128i sign = _mm_set1_epi32(is_signed_v<key_type> ? 0 : INT32_MIN);
+			const __m128i target = _mm_xor_si128(_mm_set1_epi32(key), sign);
+
+			for (uint32_t i = 0; i < count; i += 4)
+			{
+				__m128i block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), sign);
+				uint32_t mask = INCLUSIVE ? ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, target)))
+										  : _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(target, block)));
+				uint32_t lanes = MIN(count - i, 4u);
+
+				mask &= (1u << lanes) - 1;
+				result += __builtin_popcount(mask);
+
+				if (mask != (1u << lanes) - 1)
+				{
+					break;
+				}
+			}
+
+			return result;
+		}
+#endif
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			result += INCLUSIVE ? !(key < keys[i]) : keys[i] < key;
+		}
+
+		return result;
+	}
+
+	uint32_t _alloc_leaf()
+	{
+		uint32_t index = 0;
+
+		// Reuse any nodes first before allocating new ones
+		if (this->_free_leaves.size() != 0)
+		{
+			index = this->_free_leaves.back();
+			this->_free_leaves.pop_back();
+		}
+		else
+		{
+			index = this->_leaves.size();
+			this->_leaves.emplace_back();
+		}
+
+		btleaf &leaf = this->_leaves[index];
+
+		leaf.count = 0;
+		leaf.parent = 0;
+		leaf.prev = 0;
+		leaf.next = 0;
+
+		return index;
+	}
+
+	uint32_t _alloc_inner()
+	{
+		uint32_t index = 0;
+
+		if (this->_free_inners.size() != 0)
+		{
+			index = this->_free_inners.back();
+			this->_free_inners.pop_back();
+		}
+		else
+		{
+			index = this->_inners.size();
+			this->_inners.emplace_back();
+		}
+
+		btinner &inner = this->_inners[index];
+
+		inner.count = 0;
+		inner.parent = 0;
+
+		return index;
+	}
+
+	void _clear()
+	{
+		this->_leaves.resize(1);
+		this->_inners.resize(1);
+		this->_free_leaves.clear();
+		this->_free_inners.clear();
+
+		this->_root = 0;
+		this->_height = 0;
+		this->_count = 0;
+	}
+
+	priority_type _priority(uint32_t leaf, uint32_t slot)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		// Assign priority based on value or key here
+		return 0;
+	}
+
+	// Number of keys below a node
+	uint32_t _size(uint32_t node, bool leaf)
+	{
+		uint32_t result = 0;
+
+		if (leaf)
+		{
+			return this->_leaves[node].count;
+		}
+
+		btinner &inner = this->_inners[node];
+
+		for (uint32_t i = 0; i < inner.count; i++)
+		{
+			result += inner.sizes[i];
+		}
+
+		return result;
+	}
+
+	// Combined priority below a node
+	priority_type _join(uint32_t node, bool leaf)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		if (leaf)
+		{
+			btleaf &current = this->_leaves[node];
+			priority_type result = current.priority[0];
+
+			for (uint32_t i = 1; i < current.count; i++)
+			{
+				result = MIN(result, current.priority[i]);
+			}
+
+			return result;
+		}
+
+		btinner &current = this->_inners[node];
+		priority_type result = current.current[0];
+
+		for (uint32_t i = 1; i < current.count; i++)
+		{
+			result = MIN(result, current.current[i]);
+		}
+
+		return result;
+	}
+
+	uint32_t &_parent(uint32_t node, bool leaf)
+	{
+		return leaf ? this->_leaves[node].parent : this->_inners[node].parent;
+	}
+
+	uint32_t _fill(uint32_t node, bool leaf)
+	{
+		return leaf ? this->_leaves[node].count : this->_inners[node].count;
+	}
+
+	// Recompute size and current of the child at slot
+	void _refresh(uint32_t parent, uint32_t slot, bool leaf)
+	{
+		uint32_t child = this->_inners[parent].children[slot];
+
+		this->_inners[parent].sizes[slot] = this->_size(child, leaf);
+
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			this->_inners[parent].current[slot] = this->_join(child, leaf);
+		}
+	}
+
+	// Position of a child in its parent
+	uint32_t _slot(uint32_t parent, uint32_t child)
+	{
+		btinner &inner = this->_inners[parent];
+		uint32_t slot = 0;
+
+		while (inner.children[slot] != child)
+		{
+			slot++;
+		}
+
+		return slot;
+	}
+
+	// Copy one key with its value and priority between leaf slots
+	void _move(btleaf &from, uint32_t source, btleaf &to, uint32_t destination)
+	{
+		to.keys[destination] = from.keys[source];
+
+		if constexpr (!is_same_v<VALUE, void>)
+		{
+			to.values[destination] = std::move(from.values[source]);
+		}
+
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			to.priority[destination] = from.priority[source];
+		}
+	}
+
+	// Copy one child with its statistics between inner slots
+	void _move(btinner &from, uint32_t source, btinner &to, uint32_t destination)
+	{
+		to.children[destination] = from.children[source];
+		to.sizes[destination] = from.sizes[source];
+
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			to.current[destination] = from.current[source];
+		}
+	}
+
+	// Split the full child at slot into two halves, the parent must not be full.
+	// level is the level of the child, 0 for leaves.
+	void _split(uint32_t parent, uint32_t slot, uint32_t level)
+	{
+		uint32_t child = this->_inners[parent].children[slot];
+		uint32_t sibling = level == 0 ? this->_alloc_leaf() : this->_alloc_inner();
+		uint32_t half = B / 2;
+		key_type separator = {};
+
+		if (level == 0)
+		{
+			btleaf &left = this->_leaves[child];
+			btleaf &right = this->_leaves[sibling];
+
+			for (uint32_t i = half; i < left.count; i++)
+			{
+				this->_move(left, i, right, i - half);
+			}
+
+			right.count = left.count - half;
+			left.count = half;
+
+			right.prev = child;
+			right.next = left.next;
+
+			if (left.next != 0)
+			{
+				this->_leaves[left.next].prev = sibling;
+			}
+
+			left.next = sibling;
+			right.parent = parent;
+			separator = right.keys[0];
+		}
+		else
+		{
+			btinner &left = this->_inners[child];
+			btinner &right = this->_inners[sibling];
+
+			// The middle separator moves up
+			for (uint32_t i = half; i < left.count; i++)
+			{
+				this->_move(left, i, right, i - half);
+				this->_parent(right.children[i - half], level == 1) = sibling;
+
+				if (i + 1 < left.count)
+				{
+					right.keys[i - half] = left.keys[i];
+				}
+			}
+
+			separator = left.keys[half - 1];
+			right.count = left.count - half;
+			left.count = half;
+			right.parent = parent;
+		}
+
+		btinner &inner = this->_inners[parent];
+
+		for (uint32_t i = inner.count; i > slot + 1; i--)
+		{
+			this->_move(inner, i - 1, inner, i);
+			inner.keys[i - 1] = inner.keys[i - 2];
+		}
+
+		inner.children[slot + 1] = sibling;
+		inner.keys[slot] = separator;
+		inner.count += 1;
+
+		this->_refresh(parent, slot, level == 0);
+		this->_refresh(parent, slot + 1, level == 0);
+	}
+
+	pair<position, uint8_t> _insert_find(key_type key)
+	{
+		array<pair<uint32_t, uint32_t>, 32> path;
+		uint32_t depth = 0;
+
+		if (this->_root == 0)
+		{
+			this->_root = this->_alloc_leaf();
+			this->_height = 0;
+		}
+
+		// Split a full root first so that every split below has room in its parent
+		if (this->_fill(this->_root, this->_height == 0) == B)
+		{
+			uint32_t root = this->_alloc_inner();
+
+			this->_inners[root].count = 1;
+			this->_inners[root].children[0] = this->_root;
+			this->_parent(this->_root, this->_height == 0) = root;
+
+			this->_root = root;
+			this->_split(root, 0, this->_height);
+			this->_height += 1;
+		}
+
+		uint32_t node = this->_root;
+
+		// Walk down splitting full children on the way
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			uint32_t slot = this->_rank<true>(this->_inners[node].keys, this->_inners[node].count - 1, key);
+
+			if (this->_fill(this->_inners[node].children[slot], level == 1) == B)
+			{
+				this->_split(node, slot, level - 1);
+
+				if (!(key < this->_inners[node].keys[slot]))
+				{
+					slot += 1;
+				}
+			}
+
+			path[depth++] = {node, slot};
+			node = this->_inners[node].children[slot];
+		}
+
+		btleaf &leaf = this->_leaves[node];
+		uint32_t slot = this->_rank<true>(leaf.keys, leaf.count, key);
+
+		if constexpr (DUPLICATES == false)
+		{
+			if (slot != 0 && leaf.keys[slot - 1] == key)
+			{
+				return {{node, slot - 1}, 0};
+			}
+		}
+
+		for (uint32_t i = leaf.count; i > slot; i--)
+		{
+			this->_move(leaf, i - 1, leaf, i);
+		}
+
+		leaf.keys[slot] = key;
+		leaf.count += 1;
+		this->_count += 1;
+
+		if constexpr (!is_same_v<VALUE, void>)
+		{
+			leaf.values[slot] = {};
+		}
+
+		// Update statistics to root
+		while (depth != 0)
+		{
+			auto [parent, index] = path[--depth];
+
+			this->_inners[parent].sizes[index] += 1;
+		}
+
+		return {{node, slot}, 1};
+	}
+
+	// Recompute priorities from a leaf to the root
+	void _update_path(uint32_t leaf)
+	{
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			uint32_t node = leaf;
+			uint32_t parent = this->_leaves[leaf].parent;
+			bool below = true;
+
+			while (parent != 0)
+			{
+				this->_inners[parent].current[this->_slot(parent, node)] = this->_join(node, below);
+
+				node = parent;
+				parent = this->_inners[node].parent;
+				below = false;
+			}
+		}
+	}
+
+	position insert(key_type key)
+	{
+		auto [node, inserted] = this->_insert_find(key);
+
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			this->_leaves[node.leaf].priority[node.slot] = this->_priority(node.leaf, node.slot);
+			this->_update_path(node.leaf);
+		}
+
+		return node;
+	}
+
+	template <typename TYPE>
+	position insert(key_type key, TYPE value)
+		requires(!std::is_same_v<VALUE, void>)
+	{
+		auto [node, inserted] = this->_insert_find(key);
+
+		this->_leaves[node.leaf].values[node.slot] = value;
+
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			this->_leaves[node.leaf].priority[node.slot] = this->_priority(node.leaf, node.slot);
+			this->_update_path(node.leaf);
+		}
+
+		return node;
+	}
+
+	// Fix the child at slot after it dropped below half, merges with or borrows from a sibling.
+	// level is the level of the child, 0 for leaves.
+	void _rebalance(uint32_t parent, uint32_t slot, uint32_t level)
+	{
+		btinner &inner = this->_inners[parent];
+		uint8_t merged = 0;
+
+		if (inner.count < 2)
+		{
+			return;
+		}
+
+		// Work on the pair (index, index + 1)
+		uint32_t index = slot + 1 < inner.count ? slot : slot - 1;
+		uint32_t a = inner.children[index];
+		uint32_t b = inner.children[index + 1];
+
+		if (level == 0)
+		{
+			btleaf &left = this->_leaves[a];
+			btleaf &right = this->_leaves[b];
+
+			if (left.count + right.count <= B)
+			{
+				for (uint32_t i = 0; i < right.count; i++)
+				{
+					this->_move(right, i, left, left.count + i);
+				}
+
+				left.count += right.count;
+				left.next = right.next;
+
+				if (right.next != 0)
+				{
+					this->_leaves[right.next].prev = a;
+				}
+
+				this->_free_leaves.push_back(b);
+				merged = 1;
+			}
+			else if (left.count < right.count)
+			{
+				// Borrow the first key of right
+				this->_move(right, 0, left, left.count);
+
+				for (uint32_t i = 1; i < right.count; i++)
+				{
+					this->_move(right, i, right, i - 1);
+				}
+
+				left.count += 1;
+				right.count -= 1;
+				inner.keys[index] = right.keys[0];
+			}
+			else
+			{
+				// Borrow the last key of left
+				for (uint32_t i = right.count; i != 0; i--)
+				{
+					this->_move(right, i - 1, right, i);
+				}
+
+				this->_move(left, left.count - 1, right, 0);
+
+				left.count -= 1;
+				right.count += 1;
+				inner.keys[index] = right.keys[0];
+			}
+		}
+		else
+		{
+			btinner &left = this->_inners[a];
+			btinner &right = this->_inners[b];
+
+			if (left.count + right.count <= B)
+			{
+				// The separator comes down between both halves
+				left.keys[left.count - 1] = inner.keys[index];
+
+				for (uint32_t i = 0; i < right.count; i++)
+				{
+					this->_move(right, i, left, left.count + i);
+					this->_parent(right.children[i], level == 1) = a;
+
+					if (i + 1 < right.count)
+					{
+						left.keys[left.count + i] = right.keys[i];
+					}
+				}
+
+				left.count += right.count;
+				this->_free_inners.push_back(b);
+				merged = 1;
+			}
+			else if (left.count < right.count)
+			{
+				// Rotate the first child of right through the separator
+				left.keys[left.count - 1] = inner.keys[index];
+				this->_move(right, 0, left, left.count);
+				this->_parent(right.children[0], level == 1) = a;
+				inner.keys[index] = right.keys[0];
+
+				for (uint32_t i = 1; i < right.count; i++)
+				{
+					this->_move(right, i, right, i - 1);
+
+					if (i + 1 < right.count)
+					{
+						right.keys[i - 1] = right.keys[i];
+					}
+				}
+
+				left.count += 1;
+				right.count -= 1;
+			}
+			else
+			{
+				// Rotate the last child of left through the separator
+				for (uint32_t i = right.count; i != 0; i--)
+				{
+					this->_move(right, i - 1, right, i);
+
+					if (i != right.count)
+					{
+						right.keys[i] = right.keys[i - 1];
+					}
+				}
+
+				right.keys[0] = inner.keys[index];
+				this->_move(left, left.count - 1, right, 0);
+				this->_parent(right.children[0], level == 1) = b;
+				inner.keys[index] = left.keys[left.count - 2];
+
+				left.count -= 1;
+				right.count += 1;
+			}
+		}
+
+		if (merged)
+		{
+			// Drop child index + 1 and the separator before it
+			for (uint32_t i = index + 1; i + 1 < inner.count; i++)
+			{
+				this->_move(inner, i + 1, inner, i);
+			}
+
+			for (uint32_t i = index; i + 2 < inner.count; i++)
+			{
+				inner.keys[i] = inner.keys[i + 1];
+			}
+
+			inner.count -= 1;
+		}
+		else
+		{
+			this->_refresh(parent, index + 1, level == 0);
+		}
+
+		this->_refresh(parent, index, level == 0);
+	}
+
+	// Erase the key at a position, all other positions are invalidated
+	void erase(position node)
+	{
+		if (!node)
+		{
+			return;
+		}
+
+		btleaf &leaf = this->_leaves[node.leaf];
+
+		for (uint32_t i = node.slot + 1; i < leaf.count; i++)
+		{
+			this->_move(leaf, i, leaf, i - 1);
+		}
+
+		leaf.count -= 1;
+		this->_count -= 1;
+
+		// Update statistics to root, fixing underfull nodes on the way
+		uint32_t child = node.leaf;
+		uint32_t level = 0;
+		uint32_t parent = leaf.parent;
+
+		while (parent != 0)
+		{
+			uint32_t slot = this->_slot(parent, child);
+
+			this->_refresh(parent, slot, level == 0);
+
+			if (this->_fill(child, level == 0) < B / 2)
+			{
+				this->_rebalance(parent, slot, level);
+			}
+
+			child = parent;
+			parent = this->_inners[child].parent;
+			level += 1;
+		}
+
+		// Shrink the root
+		if (this->_height == 0)
+		{
+			if (this->_leaves[this->_root].count == 0)
+			{
+				this->_free_leaves.push_back(this->_root);
+				this->_root = 0;
+			}
+		}
+		else if (this->_inners[this->_root].count == 1)
+		{
+			uint32_t root = this->_root;
+
+			this->_root = this->_inners[root].children[0];
+			this->_parent(this->_root, this->_height == 1) = 0;
+			this->_free_inners.push_back(root);
+			this->_height -= 1;
+		}
+	}
+
+	void erase(key_type key)
+	{
+		this->erase(this->find(key));
+	}
+
+	void clear()
+	{
+		this->_clear();
+	}
+
+	void update(position node)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		if (!node)
+		{
+			return;
+		}
+
+		this->_leaves[node.leaf].priority[node.slot] = this->_priority(node.leaf, node.slot);
+		this->_update_path(node.leaf);
+	}
+
+	priority_type query(key_type constraint)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		// Perform a walk down one path
+		uint32_t node = this->_root;
+		priority_type result = numeric_limits<priority_type>::max();
+
+		// Copy the _bound template
+		// Example gte
+#if 0
+		if (node == 0)
+		{
+			return result;
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			btinner &inner = this->_inners[node];
+			uint32_t slot = this->_rank<false>(inner.keys, inner.count - 1, constraint);
+
+			for (uint32_t i = slot + 1; i < inner.count; i++)
+			{
+				result = MIN(result, inner.current[i]);
+			}
+
+			node = inner.children[slot];
+		}
+
+		btleaf &leaf = this->_leaves[node];
+
+		for (uint32_t i = this->_rank<false>(leaf.keys, leaf.count, constraint); i < leaf.count; i++)
+		{
+			result = MIN(result, leaf.priority[i]);
+		}
+#endif
+
+		return result;
+	}
+
+	key_type &key(position node)
+	{
+		return this->_leaves[node.leaf].keys[node.slot];
+	}
+
+	auto &value(position node)
+		requires(!std::is_same_v<VALUE, void>)
+	{
+		return this->_leaves[node.leaf].values[node.slot];
+	}
+
+	auto &priority(position node)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		return this->_leaves[node.leaf].priority[node.slot];
+	}
+
+	// First key not lesser than key, or greater than key when INCLUSIVE
+	template <bool INCLUSIVE>
+	position _bound(const key_type &key)
+	{
+		uint32_t node = this->_root;
+
+		if (node == 0)
+		{
+			return {};
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			btinner &inner = this->_inners[node];
+			node = inner.children[this->_rank<INCLUSIVE>(inner.keys, inner.count - 1, key)];
+		}
+
+		btleaf &leaf = this->_leaves[node];
+		uint32_t slot = this->_rank<INCLUSIVE>(leaf.keys, leaf.count, key);
+
+		// Separators only bound the keys, the answer can be the start of the next leaf
+		if (slot == leaf.count)
+		{
+			return {leaf.next, 0};
+		}
+
+		return {node, slot};
+	}
+
+	// Number of keys lesser than key, or not greater than key when INCLUSIVE
+	template <bool INCLUSIVE>
+	uint32_t _count_bound(const key_type &key)
+	{
+		uint32_t node = this->_root;
+		uint32_t result = 0;
+
+		if (node == 0)
+		{
+			return 0;
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			btinner &inner = this->_inners[node];
+			uint32_t slot = this->_rank<INCLUSIVE>(inner.keys, inner.count - 1, key);
+
+			for (uint32_t i = 0; i < slot; i++)
+			{
+				result += inner.sizes[i];
+			}
+
+			node = inner.children[slot];
+		}
+
+		btleaf &leaf = this->_leaves[node];
+
+		return result + this->_rank<INCLUSIVE>(leaf.keys, leaf.count, key);
+	}
+
+	position find(key_type key)
+	{
+		position node = this->_bound<false>(key);
+
+		if (!node || !(this->key(node) == key))
+		{
+			return {};
+		}
+
+		return node;
+	}
+
+	// Get the position based on its rank
+	position get(uint32_t order)
+	{
+		uint32_t node = this->_root;
+
+		if (order >= this->_count)
+		{
+			return {};
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			btinner &inner = this->_inners[node];
+			uint32_t slot = 0;
+
+			while (order >= inner.sizes[slot])
+			{
+				order -= inner.sizes[slot];
+				slot++;
+			}
+
+			node = inner.children[slot];
+		}
+
+		return {node, order};
+	}
+
+	// Get the rank of a position (0 based)
+	uint32_t order(position node)
+	{
+		uint32_t count = node.slot;
+		uint32_t child = node.leaf;
+		uint32_t parent = 0;
+
+		if (!node)
+		{
+			return UINT32_MAX;
+		}
+
+		parent = this->_leaves[child].parent;
+
+		while (parent != 0)
+		{
+			btinner &inner = this->_inners[parent];
+
+			for (uint32_t i = 0; inner.children[i] != child; i++)
+			{
+				count += inner.sizes[i];
+			}
+
+			child = parent;
+			parent = inner.parent;
+		}
+
+		return count;
+	}
+
+	uint8_t contains(key_type key)
+	{
+		return bool(this->find(key));
+	}
+
+	uint32_t size()
+	{
+		return this->_count;
+	}
+
+	// Get the first element
+	position front()
+	{
+		uint32_t node = this->_root;
+
+		if (node == 0)
+		{
+			return {};
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			node = this->_inners[node].children[0];
+		}
+
+		return {node, 0};
+	}
+
+	// Get the last element
+	position back()
+	{
+		uint32_t node = this->_root;
+
+		if (node == 0)
+		{
+			return {};
+		}
+
+		for (uint32_t level = this->_height; level != 0; level--)
+		{
+			node = this->_inners[node].children[this->_inners[node].count - 1];
+		}
+
+		return {node, this->_leaves[node].count - 1};
+	}
+
+	// Get the next element in order
+	position next(position node)
+	{
+		if (!node)
+		{
+			return {};
+		}
+
+		if (node.slot + 1 < this->_leaves[node.leaf].count)
+		{
+			return {node.leaf, node.slot + 1};
+		}
+
+		return {this->_leaves[node.leaf].next, 0};
+	}
+
+	// Get the previous element in order
+	position prev(position node)
+	{
+		if (!node)
+		{
+			return {};
+		}
+
+		if (node.slot != 0)
+		{
+			return {node.leaf, node.slot - 1};
+		}
+
+		uint32_t leaf = this->_leaves[node.leaf].prev;
+
+		if (leaf == 0)
+		{
+			return {};
+		}
+
+		return {leaf, this->_leaves[leaf].count - 1};
+	}
+
+	// Find the largest key lesser than given key
+	position find_lt(key_type key)
+	{
+		position node = this->_bound<false>(key);
+
+		return node ? this->prev(node) : this->back();
+	}
+
+	position find_lte(key_type key)
+	{
+		position node = this->_bound<true>(key);
+
+		return node ? this->prev(node) : this->back();
+	}
+
+	// Find the smallest key greater than given key
+	position find_gt(key_type key)
+	{
+		return this->_bound<true>(key);
+	}
+
+	position find_gte(key_type key)
+	{
+		return this->_bound<false>(key);
+	}
+
+	// Count the number of elements lesser than given key
+	uint32_t count_lt(key_type key)
+	{
+		return this->_count_bound<false>(key);
+	}
+
+	uint32_t count_lte(key_type key)
+	{
+		return this->_count_bound<true>(key);
+	}
+
+	// Count the number of elements greater than given key
+	uint32_t count_gt(key_type key)
+	{
+		return this->_count - this->_count_bound<true>(key);
+	}
+
+	uint32_t count_gte(key_type key)
+	{
+		return this->_count - this->_count_bound<false>(key);
+	}
+};
+
+template <typename KEY>
+using btree_set = btree<KEY, void, void, false>;
+
+template <typename KEY>
+using btree_multiset = btree<KEY, void, void, true>;
+
+template <typename KEY, typename VALUE>
+using btree_map = btree<KEY, VALUE, void, false>;
+
+template <typename KEY, typename VALUE>
+using btree_multimap = btree<KEY, VALUE, void, true>;
+
+template <typename KEY, typename PRIORITY>
+using augmented_btree_set = btree<KEY, void, PRIORITY, false>;
+
+template <typename KEY, typename VALUE, typename PRIORITY>
+using augmented_btree_map = btree<KEY, VALUE, PRIORITY, false>;
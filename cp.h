@@ -23,6 +23,15 @@
 
 // Miscellaneous
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+
+// System
+#ifndef _WIN32
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
 
 using namespace std;
 
@@ -33,6 +42,11 @@ using namespace std;
 #define ABS(a)     ((a) < 0 ? -(a) : (a))
 #define CDIV(a, b) (((a) + ((b) - 1)) / (b))
 
+// Interactive problems read input on demand through cin
+#ifndef INTERACTIVE
+#	define INTERACTIVE 0
+#endif
+
 template <typename T>
 using min_priority_queue = priority_queue<T, vector<T>, greater<T>>;
 
@@ -49,3 +63,199 @@ template <typename O, typename T>
 concept commutative_operator = requires(O op, T a) {
 	{ op.inverse(a, a) } -> std::same_as<T>;
 } && binary_operator<O, T>;
+
+template <typename T>
+concept container = requires(T a) {
+	a.begin();
+	a.end();
+} && !std::same_as<std::remove_cvref_t<T>, string>;
+
+// Fast input
+template <typename T>
+concept character = same_as<T, char> || same_as<T, signed char> || same_as<T, unsigned char>;
+
+struct fast_input
+{
+	vector<char> storage;
+	const char *buffer = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+
+	fast_input()
+	{
+#ifndef _WIN32
+		struct stat info;
+
+		// Map stdin directly if it is a file
+		if (fstat(0, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+		{
+			void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+
+			if (map != MAP_FAILED)
+			{
+				this->buffer = static_cast<const char *>(map);
+				this->size = info.st_size;
+
+				return;
+			}
+		}
+#endif
+
+		// Otherwise slurp everything into one buffer
+		size_t count = 0;
+		this->storage.resize(1 << 16);
+
+		while ((count = fread(this->storage.data() + this->size, 1, this->storage.size() - this->size, stdin)) != 0)
+		{
+			this->size += count;
+
+			if (this->size == this->storage.size())
+			{
+				this->storage.resize(this->size * 2);
+			}
+		}
+
+		this->buffer = this->storage.data();
+	}
+
+	void _skip()
+	{
+		while (this->pos < this->size && this->buffer[this->pos] <= ' ')
+		{
+			this->pos += 1;
+		}
+	}
+
+	template <character T>
+	void read(T &value)
+	{
+		this->_skip();
+
+		if (this->pos < this->size)
+		{
+			value = this->buffer[this->pos++];
+		}
+	}
+
+	void read(bool &value)
+	{
+		this->_skip();
+
+		if (this->pos < this->size)
+		{
+			value = this->buffer[this->pos++] != '0';
+		}
+	}
+
+	template <integral T>
+		requires(!character<T> && !same_as<T, bool>)
+	void read(T &value)
+	{
+		make_unsigned_t<T> result = 0;
+		uint8_t negative = 0;
+		uint8_t digit = 0;
+
+		this->_skip();
+
+		if constexpr (is_signed_v<T>)
+		{
+			if (this->pos < this->size && this->buffer[this->pos] == '-')
+			{
+				negative = 1;
+				this->pos += 1;
+			}
+		}
+
+		while (this->pos < this->size && (digit = this->buffer[this->pos] - '0') < 10)
+		{
+			result = (result * 10) + digit;
+			this->pos += 1;
+		}
+
+		value = negative ? NEG(result) : result;
+	}
+
+	template <floating_point T>
+	void read(T &value)
+	{
+		this->_skip();
+		this->pos = from_chars(this->buffer + this->pos, this->buffer + this->size, value).ptr - this->buffer;
+	}
+
+	void read(string &value)
+	{
+		size_t start = 0;
+
+		this->_skip();
+		start = this->pos;
+
+		while (this->pos < this->size && this->buffer[this->pos] > ' ')
+		{
+			this->pos += 1;
+		}
+
+		value.assign(this->buffer + start, this->pos - start);
+	}
+
+	template <typename T1, typename T2>
+	void read(pair<T1, T2> &p)
+	{
+		this->read(p.first);
+		this->read(p.second);
+	}
+
+	template <container T>
+	void read(T &container)
+	{
+		for (auto &x : container)
+		{
+			this->read(x);
+		}
+	}
+
+	// Anything else goes through its operator>> over the unread part of the buffer
+	struct _view : streambuf
+	{
+		_view(const char *begin, const char *end)
+		{
+			this->setg(const_cast<char *>(begin), const_cast<char *>(begin), const_cast<char *>(end));
+		}
+
+		const char *position() const
+		{
+			return this->gptr();
+		}
+	};
+
+	template <typename T>
+	void read(T &value)
+	{
+		_view view(this->buffer + this->pos, this->buffer + this->size);
+		istream stream(&view);
+
+		stream >> value;
+		this->pos = view.position() - this->buffer;
+	}
+};
+
+static fast_input &reader()
+{
+	static fast_input in;
+	return in;
+}
+
+// IO
+template <typename... T>
+static void input(T &...args)
+{
+	if constexpr (INTERACTIVE)
+	{
+		((cin >> args), ...);
+	}
+	else
+	{
+		(reader().read(args), ...);
+	}
+}
+
+#define IN(...) input(__VA_ARGS__)
@@ -500,7 +500,7 @@ struct mo
 
 		for (uint32_t i = 0; i < count; ++i)
 		{
-			cin >> this->queries[i].left >> this->queries[i].right;
+			input(this->queries[i].left, this->queries[i].right);
 
 			this->queries[i].left--;
 			this->queries[i].right--;
@@ -1,12 +1,25 @@
 #include "cp.h"
-#include "ds.cpp"
-#include "ops.cpp"
+#include "heap.cpp"
+
+#include <atomic>
+#include <barrier>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <variant>
 
 using namespace std;
 
-template <bool DIRECTED = false, bool TREE = false>
+// CSR packs the adjacency lists into one array indexed by offsets, built once by counting sort
+// WEIGHT is stored on every edge, monostate takes no space
+template <bool DIRECTED = false, bool TREE = false, bool CSR = false, typename WEIGHT = monostate>
 struct graph_base
 {
+	using weight_type = WEIGHT;
+
+	static constexpr bool csr = CSR;
+
 	struct vertex
 	{
 		// Specifics
@@ -20,7 +33,7 @@ struct graph_base
 		// uint8_t ignore = 0;
 
 		// Specifics
-		// uint64_t weight;
+		[[no_unique_address]] WEIGHT weight;
 	};
 
 	struct list
@@ -36,9 +49,20 @@ struct graph_base
 	vector<vertex> vertices;
 	vector<vector<list>> adjlist;
 
-	vector<list> &operator[](uint32_t index)
+	// CSR storage, neighbours of v are targets[offsets[v] .. offsets[v + 1])
+	vector<uint32_t> offsets;
+	vector<list> targets;
+
+	decltype(auto) operator[](uint32_t index)
 	{
-		return this->adjlist[index];
+		if constexpr (CSR)
+		{
+			return span<list>(this->targets.data() + this->offsets[index], this->offsets[index + 1] - this->offsets[index]);
+		}
+		else
+		{
+			return (this->adjlist[index]);
+		}
 	}
 
 	graph_base() {};
@@ -71,13 +95,13 @@ struct graph_base
 
 		for (uint32_t i = 0; i < this->vertex_count; ++i)
 		{
-			cin >> this->vertices[i].property;
+			input(this->vertices[i].property);
 		}
 	}
 
-	void add_edge(uint32_t source, uint32_t destination)
+	void add_edge(uint32_t source, uint32_t destination, WEIGHT weight = {})
 	{
-		this->edges.push_back({source, destination});
+		this->edges.push_back({source, destination, weight});
 
 		if constexpr (TREE == 0)
 		{
@@ -91,7 +115,12 @@ struct graph_base
 
 		for (uint32_t i = 0; i < this->edge_count; ++i)
 		{
-			cin >> this->edges[i].source >> this->edges[i].destination;
+			input(this->edges[i].source, this->edges[i].destination);
+
+			if constexpr (!is_empty_v<WEIGHT>)
+			{
+				input(this->edges[i].weight);
+			}
 
 			this->edges[i].source--;
 			this->edges[i].destination--;
@@ -101,6 +130,42 @@ struct graph_base
 
 	void build()
 	{
+		if constexpr (CSR)
+		{
+			this->offsets = vector<uint32_t>(this->vertex_count + 1, 0);
+
+			for (uint32_t i = 0; i < this->edge_count; ++i)
+			{
+				this->offsets[this->edges[i].source + 1]++;
+
+				if constexpr (DIRECTED == 0)
+				{
+					this->offsets[this->edges[i].destination + 1]++;
+				}
+			}
+
+			for (uint32_t i = 0; i < this->vertex_count; ++i)
+			{
+				this->offsets[i + 1] += this->offsets[i];
+			}
+
+			// Stable fill keeps the same neighbour order as the list backend
+			vector<uint32_t> next(this->offsets.begin(), this->offsets.end() - 1);
+			this->targets = vector<list>(this->offsets[this->vertex_count]);
+
+			for (uint32_t i = 0; i < this->edge_count; ++i)
+			{
+				this->targets[next[this->edges[i].source]++] = {this->edges[i].destination, i};
+
+				if constexpr (DIRECTED == 0)
+				{
+					this->targets[next[this->edges[i].destination]++] = {this->edges[i].source, i};
+				}
+			}
+
+			return;
+		}
+
 		this->adjlist = vector<vector<list>>(this->vertex_count);
 
 		for (uint32_t i = 0; i < this->edge_count; ++i)
@@ -124,8 +189,33 @@ using undirected_graph = graph_base<false, false>;
 using directed_graph = graph_base<true, false>;
 using tree = graph_base<false, true>;
 
+using csr_undirected_graph = graph_base<false, false, true>;
+using csr_directed_graph = graph_base<true, false, true>;
+using csr_tree = graph_base<false, true, true>;
+
+template <typename WEIGHT = uint64_t, bool CSR = false>
+using weighted_undirected_graph = graph_base<false, false, CSR, WEIGHT>;
+
+template <typename WEIGHT = uint64_t, bool CSR = false>
+using weighted_directed_graph = graph_base<true, false, CSR, WEIGHT>;
+
+template <typename WEIGHT = uint64_t, bool CSR = false>
+using weighted_tree = graph_base<false, true, CSR, WEIGHT>;
+
+template <typename T, bool DIRECTED, bool TREE>
+concept graph_kind = same_as<T, graph_base<DIRECTED, TREE, T::csr, typename T::weight_type>>;
+
+template <typename T>
+concept directed_graph_type = graph_kind<T, true, false>;
+
+template <typename T>
+concept tree_type = graph_kind<T, false, true>;
+
 template <typename T>
-concept graph_type = same_as<T, undirected_graph> || same_as<T, directed_graph> || same_as<T, tree>;
+concept graph_type = graph_kind<T, false, false> || directed_graph_type<T> || tree_type<T>;
+
+template <typename T>
+concept weighted_graph_type = graph_type<T> && !is_empty_v<typename T::weight_type>;
 
 template <graph_type T>
 vector<pair<uint32_t, uint32_t>> dfs_parents(T &graph, uint32_t root)
@@ -190,14 +280,14 @@ auto dfs_path(T &graph, uint32_t source, uint32_t destination)
 
 	uint32_t current = destination;
 
-	path_edges.push_back(parents[current][1]);
+	path_edges.push_back(parents[current].second);
 	path_vertices.push_back(current);
 
 	while (path_edges.back() != UINT32_MAX)
 	{
-		current = parents[current][0];
+		current = parents[current].first;
 
-		path_edges.push_back(parents[current][1]);
+		path_edges.push_back(parents[current].second);
 		path_vertices.push_back(current);
 	}
 
@@ -209,7 +299,8 @@ auto dfs_path(T &graph, uint32_t source, uint32_t destination)
 	return make_pair(path_edges, path_vertices);
 }
 
-vector<uint32_t> dfs_sort(directed_graph &graph)
+template <directed_graph_type T>
+vector<uint32_t> dfs_sort(T &graph)
 {
 	vector<uint8_t> visited(graph.size(), 0);
 	vector<uint32_t> order;
@@ -364,7 +455,185 @@ vector<uint32_t> dfs_bridges(T &graph, uint32_t index)
 	return bridges;
 }
 
-vector<uint32_t> dfs_hash(tree &tree, uint32_t root)
+// Flat output of dfs_lowlink, blocks are the biconnected components and own every edge except self loops
+// In block_cut, block b is vertex b and articulation point v is vertex block_count + cut_ids[v]
+struct lowlink
+{
+	vector<uint32_t> bridges;
+	vector<uint8_t> articulation;
+
+	vector<uint32_t> two_edge;
+	uint32_t two_edge_count = 0;
+
+	vector<uint32_t> blocks;
+	uint32_t block_count = 0;
+
+	vector<uint32_t> cut_ids;
+	csr_undirected_graph block_cut;
+};
+
+// One iterative lowlink pass over every component, parallel edges are told apart by edge id
+template <graph_type T>
+	requires(!directed_graph_type<T>)
+lowlink dfs_lowlink(T &graph)
+{
+	uint32_t size = graph.size();
+
+	vector<uint32_t> entry(size, 0);
+	vector<uint32_t> low(size, 0);
+	vector<uint32_t> open_vertices;
+	vector<uint32_t> open_edges;
+	vector<uint32_t> order;
+	stack<array<uint32_t, 3>> st;
+
+	lowlink result;
+	uint32_t timer = 0;
+
+	result.articulation = vector<uint8_t>(size, 0);
+	result.two_edge = vector<uint32_t>(size);
+	result.blocks = vector<uint32_t>(graph.edges.size(), UINT32_MAX);
+	result.cut_ids = vector<uint32_t>(size, UINT32_MAX);
+
+	for (uint32_t root = 0; root < size; ++root)
+	{
+		uint32_t children = 0;
+
+		if (entry[root] != 0)
+		{
+			continue;
+		}
+
+		st.push({root, UINT32_MAX, 0});
+		entry[root] = low[root] = ++timer;
+		open_vertices.push_back(root);
+
+		while (st.size() != 0)
+		{
+			uint32_t source = st.top()[0];
+			uint32_t incoming = st.top()[1];
+			uint32_t &start = st.top()[2];
+
+			if (start < graph[source].size())
+			{
+				uint32_t destination = graph[source][start].vertex;
+				uint32_t edge = graph[source][start].edge;
+
+				start += 1;
+
+				if (edge == incoming)
+				{
+					continue;
+				}
+
+				// New vertex
+				if (entry[destination] == 0)
+				{
+					children += source == root;
+					open_edges.push_back(edge);
+
+					st.push({destination, edge, 0});
+					entry[destination] = low[destination] = ++timer;
+					open_vertices.push_back(destination);
+				}
+				// Back edge, kept once from its lower end
+				else if (entry[destination] < entry[source])
+				{
+					low[source] = MIN(low[source], entry[destination]);
+					open_edges.push_back(edge);
+				}
+
+				continue;
+			}
+
+			st.pop();
+
+			// Nothing below source reaches above it, so source closes a 2-edge-connected component
+			if (low[source] == entry[source])
+			{
+				uint32_t vertex;
+
+				do
+				{
+					vertex = open_vertices.back();
+					open_vertices.pop_back();
+					result.two_edge[vertex] = result.two_edge_count;
+				} while (vertex != source);
+
+				result.two_edge_count += 1;
+			}
+
+			if (st.size() == 0)
+			{
+				continue;
+			}
+
+			uint32_t parent = st.top()[0];
+
+			low[parent] = MIN(low[parent], low[source]);
+
+			if (low[source] > entry[parent])
+			{
+				result.bridges.push_back(incoming);
+			}
+
+			// Parent separates the subtree of source, which closes a block ending at the tree edge
+			if (low[source] >= entry[parent])
+			{
+				uint32_t edge;
+
+				result.articulation[parent] |= parent != root;
+
+				do
+				{
+					edge = open_edges.back();
+					open_edges.pop_back();
+					result.blocks[edge] = result.block_count;
+					order.push_back(edge);
+				} while (edge != incoming);
+
+				result.block_count += 1;
+			}
+		}
+
+		result.articulation[root] = children >= 2;
+	}
+
+	uint32_t cuts = 0;
+
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		if (result.articulation[i])
+		{
+			result.cut_ids[i] = cuts++;
+		}
+	}
+
+	// Edges of a block are contiguous in order, so one marker per vertex removes duplicates
+	vector<uint32_t> last(size, UINT32_MAX);
+
+	result.block_cut = csr_undirected_graph(result.block_count + cuts);
+
+	for (uint32_t edge : order)
+	{
+		uint32_t block = result.blocks[edge];
+
+		for (uint32_t vertex : {graph.edges[edge].source, graph.edges[edge].destination})
+		{
+			if (result.articulation[vertex] && last[vertex] != block)
+			{
+				last[vertex] = block;
+				result.block_cut.add_edge(block, result.block_count + result.cut_ids[vertex]);
+			}
+		}
+	}
+
+	result.block_cut.build();
+
+	return result;
+}
+
+template <tree_type T>
+vector<uint32_t> dfs_hash(T &tree, uint32_t root)
 {
 	vector<uint8_t> visited(tree.size(), 0);
 	stack<array<uint32_t, 2>> st;
@@ -427,7 +696,8 @@ vector<uint32_t> dfs_hash(tree &tree, uint32_t root)
 	return hashes;
 }
 
-uint8_t dfs_games(directed_graph &graph, uint32_t index)
+template <directed_graph_type T>
+uint8_t dfs_games(T &graph, uint32_t index)
 {
 	vector<uint8_t> visited(graph.size(), 0);
 	vector<uint8_t> status(graph.size(), 0);
@@ -478,94 +748,141 @@ uint8_t dfs_games(directed_graph &graph, uint32_t index)
 	return status[index];
 }
 
-auto dfs_components(directed_graph &graph)
+// Iterative Tarjan, ids[v] is the strongly connected component of v and ids follow a topological order of the condensation
+template <directed_graph_type T>
+pair<vector<uint32_t>, uint32_t> dfs_scc(T &graph)
 {
-	vector<uint8_t> visited(graph.size(), 0);
-	vector<uint32_t> order;
+	uint32_t size = graph.size();
+
+	vector<uint32_t> ids(size, UINT32_MAX);
+	vector<uint32_t> order(size, UINT32_MAX);
+	vector<uint32_t> low(size);
+	vector<uint32_t> open;
+	stack<array<uint32_t, 2>> st;
+
+	uint32_t counter = 0;
+	uint32_t count = 0;
 
-	auto dfs = [&](directed_graph &dag, vector<uint32_t> &out, uint32_t index) -> bool
+	for (uint32_t i = 0; i < size; ++i)
 	{
-		stack<array<uint32_t, 2>> st;
+		if (order[i] != UINT32_MAX)
+		{
+			continue;
+		}
 
-		st.push({index, 0});
-		visited[index] = 1;
+		st.push({i, 0});
+		order[i] = low[i] = counter++;
+		open.push_back(i);
 
 		while (st.size() != 0)
 		{
 			uint32_t source = st.top()[0];
 			uint32_t &start = st.top()[1];
-			uint8_t pop = 1;
 
-			while (start < dag[source].size())
+			if (start < graph[source].size())
 			{
-				uint32_t destination = dag[source][start].vertex;
+				uint32_t destination = graph[source][start].vertex;
+
+				start += 1;
 
 				// New vertex
-				if (visited[destination] == 0)
+				if (order[destination] == UINT32_MAX)
 				{
 					st.push({destination, 0});
-					visited[destination] = 1;
-
-					pop = 0;
-					break;
+					order[destination] = low[destination] = counter++;
+					open.push_back(destination);
+				}
+				// Still open, so part of the current path's components
+				else if (ids[destination] == UINT32_MAX)
+				{
+					low[source] = MIN(low[source], order[destination]);
 				}
 
-				start += 1;
+				continue;
 			}
 
-			if (pop)
+			st.pop();
+
+			if (low[source] == order[source])
 			{
-				out.push_back(source);
-				st.pop();
+				uint32_t vertex;
 
-				if (st.size() != 0)
+				do
 				{
-					st.top()[1] += 1;
-				}
+					vertex = open.back();
+					open.pop_back();
+					ids[vertex] = count;
+				} while (vertex != source);
+
+				count += 1;
+			}
+
+			if (st.size() != 0)
+			{
+				low[st.top()[0]] = MIN(low[st.top()[0]], low[source]);
 			}
 		}
+	}
 
-		return 0;
-	};
+	// Tarjan closes components in reverse topological order
+	for (uint32_t &id : ids)
+	{
+		id = count - 1 - id;
+	}
+
+	return make_pair(ids, count);
+}
+
+template <directed_graph_type T>
+vector<vector<uint32_t>> dfs_components(T &graph)
+{
+	auto [ids, count] = dfs_scc(graph);
+	vector<vector<uint32_t>> components(count);
 
 	for (uint32_t i = 0; i < graph.size(); ++i)
 	{
-		if (visited[i] == 0)
-		{
-			dfs(graph, order, i);
-		}
+		components[ids[i]].push_back(i);
 	}
 
-	directed_graph transpose_graph(graph.size());
+	return components;
+}
+
+// Condensation DAG over component ids from dfs_scc, without self loops or parallel edges
+template <directed_graph_type T>
+csr_directed_graph condensation(T &graph, vector<uint32_t> &ids, uint32_t count)
+{
+	csr_directed_graph all(count), dag(count);
+	vector<uint32_t> last(count, UINT32_MAX);
 
 	for (auto &edge : graph.edges)
 	{
-		transpose_graph.add_edge(edge.destination, edge.source);
+		if (ids[edge.source] != ids[edge.destination])
+		{
+			all.add_edge(ids[edge.source], ids[edge.destination]);
+		}
 	}
 
-	transpose_graph.build();
-
-	reverse(order.begin(), order.end());
-	fill(visited.begin(), visited.end(), 0);
-
-	vector<vector<uint32_t>> components;
+	all.build();
 
-	for (uint32_t i = 0; i < graph.size(); ++i)
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		uint32_t index = order[i];
-		vector<uint32_t> current;
-
-		if (visited[index] == 0)
+		for (auto [destination, edge] : all[i])
 		{
-			dfs(transpose_graph, current, index);
-			components.push_back(current);
+			if (last[destination] != i)
+			{
+				last[destination] = i;
+				dag.add_edge(i, destination);
+			}
 		}
 	}
 
-	return components;
+	dag.build();
+
+	return dag;
 }
 
-vector<uint32_t> dfs_counts(tree &tree, uint32_t root)
+template <tree_type T>
+vector<uint32_t> dfs_counts(T &tree, uint32_t root)
 {
 	vector<uint32_t> counts(tree.size());
 	vector<uint64_t> totals(tree.size(), 0);
@@ -616,7 +933,8 @@ vector<uint32_t> dfs_counts(tree &tree, uint32_t root)
 	return counts;
 }
 
-vector<uint32_t> dfs_leaves(tree &tree, uint32_t root)
+template <tree_type T>
+vector<uint32_t> dfs_leaves(T &tree, uint32_t root)
 {
 	vector<uint32_t> counts(tree.size(), 0);
 	vector<uint8_t> visited(tree.size(), 0);
@@ -675,7 +993,8 @@ vector<uint32_t> dfs_leaves(tree &tree, uint32_t root)
 	return counts;
 }
 
-uint32_t dfs_centroid(tree &tree, uint32_t index)
+template <tree_type T>
+uint32_t dfs_centroid(T &tree, uint32_t index)
 {
 	vector<vector<uint32_t>> counts(tree.size());
 	vector<uint8_t> visited(tree.size(), 0);
@@ -788,7 +1107,8 @@ uint32_t dfs_centroid(tree &tree, uint32_t index)
 	return centroid;
 }
 
-auto dfs_tour(tree &tree, uint32_t root)
+template <tree_type T>
+auto dfs_tour(T &tree, uint32_t root)
 {
 	vector<uint8_t> visited(tree.size(), 0);
 	stack<array<uint32_t, 2>> st;
@@ -910,7 +1230,8 @@ vector<array<uint32_t, 2>> dfs_cycle(T &graph, uint32_t index)
 	return cycle;
 }
 
-uint64_t dfs_dp(tree &tree, uint32_t root)
+template <tree_type T>
+uint64_t dfs_dp(T &tree, uint32_t root)
 {
 	vector<pair<uint64_t, uint64_t>> counts(tree.size(), {0, 0});
 	vector<uint8_t> visited(tree.size(), 0);
@@ -964,445 +1285,1689 @@ uint64_t dfs_dp(tree &tree, uint32_t root)
 	return (counts[root].first + counts[root].second);
 }
 
-template <graph_type T>
-vector<uint32_t> bfs_distances(T &graph, uint32_t index)
+// Fixed set of workers, run(task) calls task(worker) on every worker and returns once all are done
+struct thread_pool
 {
-	vector<uint32_t> distances(graph.size(), 0);
-	vector<uint8_t> visited(graph.size(), 0);
-	queue<uint32_t> qu;
-
-	qu.push(index);
-	visited[index] = 1;
-	distances[index] = 0;
+	vector<thread> workers;
+	function<void(uint32_t)> task;
+	barrier<> start, finish;
+	bool stop = false;
 
-	while (qu.size() != 0)
+	thread_pool(uint32_t count) : start(count + 1), finish(count + 1)
 	{
-		uint32_t source = qu.front();
-
-		for (uint32_t i = 0; i < graph[source].size(); ++i)
+		for (uint32_t i = 0; i < count; ++i)
 		{
-			uint32_t destination = graph[source][i].vertex;
+			this->workers.emplace_back(
+				[this, i]()
+				{
+					while (true)
+					{
+						this->start.arrive_and_wait();
 
-			if (visited[destination] == 0)
-			{
-				qu.push(destination);
-				visited[destination] = 1;
-				distances[destination] = distances[source] + 1;
-			}
-		}
+						if (this->stop)
+						{
+							break;
+						}
 
-		qu.pop();
+						this->task(i);
+						this->finish.arrive_and_wait();
+					}
+				});
+		}
 	}
 
-	return distances;
-}
-
-template <graph_type T>
-void bfs_multi(T &graph, vector<uint32_t> &sources, vector<uint32_t> &mins)
-{
-	vector<uint32_t> distances(graph.size(), UINT32_MAX);
-	vector<uint32_t> visited(graph.size(), 0);
-	queue<uint32_t> qu;
-
-	for (uint32_t s : sources)
+	void run(function<void(uint32_t)> task)
 	{
-		if (visited[s] == 0)
-		{
-			visited[s] = 1;
-			distances[s] = 0;
-			qu.push(s);
-		}
+		this->task = std::move(task);
+		this->start.arrive_and_wait();
+		this->finish.arrive_and_wait();
 	}
 
-	while (qu.size() != 0)
+	~thread_pool()
 	{
-		uint32_t source = qu.front();
+		this->stop = true;
+		this->start.arrive_and_wait();
 
-		for (uint32_t i = 0; i < graph[source].size(); ++i)
+		for (auto &worker : this->workers)
 		{
-			uint32_t destination = graph[source][i].vertex;
-
-			if (visited[destination] == 0)
-			{
-				qu.push(destination);
-				visited[destination] = 1;
-				distances[destination] = distances[source] + 1;
-				mins[destination] = MIN(mins[destination], mins[source]);
-			}
-			else
-			{
-				if (distances[destination] == distances[source] + 1)
-				{
-					mins[destination] = MIN(mins[destination], mins[source]);
-				}
-			}
+			worker.join();
 		}
-
-		qu.pop();
 	}
-}
+};
 
-vector<uint64_t> dijkstra(undirected_graph &graph, uint32_t index)
+// Level synchronous BFS, unreached vertices keep UINT32_MAX
+// Undirected graphs switch to bottom-up levels once the frontier touches enough of the unvisited edges (Beamer)
+// With MINS, mins[v] becomes the minimum of itself and mins over its neighbours one level closer
+template <bool MINS, graph_type T>
+vector<uint32_t> _bfs_levels(T &graph, vector<uint32_t> &sources, vector<uint32_t> &mins, uint32_t threads)
 {
-	vector<uint64_t> distances(graph.size(), UINT64_MAX);
-	min_priority_queue<pair<uint64_t, uint32_t>> pq;
+	constexpr uint64_t alpha = 14, beta = 24;
 
-	distances[index] = 0;
-	pq.push({0, index});
+	// Zero threads runs on the caller like one
+	threads = MAX(threads, 1u);
 
-	while (pq.size() != 0)
-	{
-		uint32_t source = pq.top().second;
-		uint64_t dist = pq.top().first;
+	uint32_t size = graph.size();
+	uint32_t words = (size + 63) / 64;
+
+	vector<uint32_t> distances(size, UINT32_MAX);
+	vector<uint64_t> visited(words, 0), frontier(words, 0), next(words, 0);
+	vector<uint32_t> frontier_list;
+	vector<vector<uint32_t>> local(threads);
+	vector<uint64_t> counts(threads), degrees(threads);
 
-		pq.pop();
+	unique_ptr<thread_pool> pool = threads > 1 ? make_unique<thread_pool>(threads) : nullptr;
 
-		if (dist != distances[source])
+	auto parallel = [&](function<void(uint32_t)> task)
+	{
+		if (pool)
 		{
-			continue;
+			pool->run(std::move(task));
 		}
-
-		for (uint32_t i = 0; i < graph[source].size(); ++i)
+		else
 		{
-			uint32_t destination = graph[source][i].vertex;
-			uint32_t edge = graph[source][i].edge;
-			uint64_t weight = 0; // graph.edges[edge].ignore;
-
-			if (weight + distances[source] < distances[destination])
+			task(0);
+		}
+	};
+
+	// Returns true for the single caller that marks the vertex
+	auto claim = [&](uint32_t vertex) -> bool
+	{
+		uint64_t bit = 1ull << (vertex & 63);
+
+		if (threads == 1)
+		{
+			uint8_t fresh = (visited[vertex >> 6] & bit) == 0;
+			visited[vertex >> 6] |= bit;
+
+			return fresh;
+		}
+
+		atomic_ref<uint64_t> word(visited[vertex >> 6]);
+
+		return (word.load(memory_order_relaxed) & bit) == 0 && (word.fetch_or(bit, memory_order_relaxed) & bit) == 0;
+	};
+
+	auto lower = [&](uint32_t vertex, uint32_t value)
+	{
+		if (threads == 1)
+		{
+			mins[vertex] = MIN(mins[vertex], value);
+			return;
+		}
+
+		atomic_ref<uint32_t> current(mins[vertex]);
+		uint32_t expected = current.load(memory_order_relaxed);
+
+		while (value < expected && !current.compare_exchange_weak(expected, value, memory_order_relaxed))
+		{
+		}
+	};
+
+	uint64_t unexplored = 0, frontier_count = 0, frontier_degree = 0;
+
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		unexplored += graph[i].size();
+	}
+
+	for (uint32_t s : sources)
+	{
+		if (claim(s))
+		{
+			distances[s] = 0;
+			frontier_list.push_back(s);
+
+			frontier_count += 1;
+			frontier_degree += graph[s].size();
+		}
+	}
+
+	uint8_t bottom_up = 0;
+	unexplored -= frontier_degree;
+
+	for (uint32_t level = 0; frontier_count != 0; ++level)
+	{
+		if constexpr (!directed_graph_type<T>)
+		{
+			if (bottom_up == 0 && frontier_degree > unexplored / alpha)
+			{
+				bottom_up = 1;
+				fill(frontier.begin(), frontier.end(), 0);
+
+				for (uint32_t vertex : frontier_list)
+				{
+					frontier[vertex >> 6] |= 1ull << (vertex & 63);
+				}
+			}
+			else if (bottom_up == 1 && frontier_count < size / beta)
+			{
+				bottom_up = 0;
+				frontier_list.clear();
+
+				for (uint32_t i = 0; i < words; ++i)
+				{
+					for (uint64_t word = frontier[i]; word != 0; word &= word - 1)
+					{
+						frontier_list.push_back(i * 64 + __builtin_ctzll(word));
+					}
+				}
+			}
+		}
+
+		if (bottom_up)
+		{
+			// Every worker owns a range of bitmap words, so visited and next need no atomics
+			parallel(
+				[&](uint32_t worker)
+				{
+					uint32_t begin = (uint64_t)words * worker / threads;
+					uint32_t end = (uint64_t)words * (worker + 1) / threads;
+
+					counts[worker] = 0;
+					degrees[worker] = 0;
+
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						uint64_t found = 0;
+						uint64_t unseen = ~visited[i];
+
+						if (i == words - 1 && (size & 63) != 0)
+						{
+							unseen &= (1ull << (size & 63)) - 1;
+						}
+
+						for (; unseen != 0; unseen &= unseen - 1)
+						{
+							uint32_t destination = i * 64 + __builtin_ctzll(unseen);
+
+							for (uint32_t j = 0; j < graph[destination].size(); ++j)
+							{
+								uint32_t source = graph[destination][j].vertex;
+
+								if ((frontier[source >> 6] >> (source & 63)) & 1)
+								{
+									if (distances[destination] == UINT32_MAX)
+									{
+										distances[destination] = level + 1;
+										found |= unseen & -unseen;
+									}
+
+									if constexpr (MINS)
+									{
+										mins[destination] = MIN(mins[destination], mins[source]);
+									}
+									else
+									{
+										break;
+									}
+								}
+							}
+						}
+
+						visited[i] |= found;
+						next[i] = found;
+
+						for (; found != 0; found &= found - 1)
+						{
+							counts[worker] += 1;
+							degrees[worker] += graph[i * 64 + __builtin_ctzll(found)].size();
+						}
+					}
+				});
+
+			swap(frontier, next);
+		}
+		else
+		{
+			parallel(
+				[&](uint32_t worker)
+				{
+					uint32_t begin = (uint64_t)frontier_list.size() * worker / threads;
+					uint32_t end = (uint64_t)frontier_list.size() * (worker + 1) / threads;
+
+					local[worker].clear();
+					degrees[worker] = 0;
+
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						uint32_t source = frontier_list[i];
+
+						for (uint32_t j = 0; j < graph[source].size(); ++j)
+						{
+							uint32_t destination = graph[source][j].vertex;
+
+							if (claim(destination))
+							{
+								distances[destination] = level + 1;
+								local[worker].push_back(destination);
+								degrees[worker] += graph[destination].size();
+							}
+						}
+					}
+
+					counts[worker] = local[worker].size();
+				});
+
+			// Distances of the next level are settled only after every worker finished claiming
+			if constexpr (MINS)
+			{
+				parallel(
+					[&](uint32_t worker)
+					{
+						uint32_t begin = (uint64_t)frontier_list.size() * worker / threads;
+						uint32_t end = (uint64_t)frontier_list.size() * (worker + 1) / threads;
+
+						for (uint32_t i = begin; i < end; ++i)
+						{
+							uint32_t source = frontier_list[i];
+
+							for (uint32_t j = 0; j < graph[source].size(); ++j)
+							{
+								uint32_t destination = graph[source][j].vertex;
+
+								if (distances[destination] == level + 1)
+								{
+									lower(destination, mins[source]);
+								}
+							}
+						}
+					});
+			}
+
+			frontier_list.clear();
+
+			for (uint32_t worker = 0; worker < threads; ++worker)
+			{
+				frontier_list.insert(frontier_list.end(), local[worker].begin(), local[worker].end());
+			}
+		}
+
+		frontier_count = 0;
+		frontier_degree = 0;
+
+		for (uint32_t worker = 0; worker < threads; ++worker)
+		{
+			frontier_count += counts[worker];
+			frontier_degree += degrees[worker];
+		}
+
+		unexplored -= frontier_degree;
+	}
+
+	return distances;
+}
+
+// Unreached vertices get distance 0
+template <graph_type T>
+vector<uint32_t> bfs_distances(T &graph, uint32_t index, uint32_t threads = 1)
+{
+	vector<uint32_t> sources = {index};
+	vector<uint32_t> mins;
+	vector<uint32_t> distances = _bfs_levels<false>(graph, sources, mins, threads);
+
+	for (uint32_t &distance : distances)
+	{
+		distance = distance == UINT32_MAX ? 0 : distance;
+	}
+
+	return distances;
+}
+
+template <graph_type T>
+void bfs_multi(T &graph, vector<uint32_t> &sources, vector<uint32_t> &mins, uint32_t threads = 1)
+{
+	_bfs_levels<true>(graph, sources, mins, threads);
+}
+
+// Integral weights use a radix heap, anything else an indexed 4-ary heap, weights must be non-negative
+// Stops once target is settled, distances of vertices not yet settled are upper bounds
+template <weighted_graph_type T>
+auto dijkstra_multi(T &graph, vector<uint32_t> &sources, uint32_t target = UINT32_MAX)
+{
+	using weight_type = typename T::weight_type;
+	using distance_type = conditional_t<is_integral_v<weight_type>, uint64_t, weight_type>;
+
+	vector<distance_type> distances(graph.size(), numeric_limits<distance_type>::max());
+
+	auto search = [&](auto &heap)
+	{
+		for (uint32_t s : sources)
+		{
+			if (distances[s] != 0)
+			{
+				distances[s] = 0;
+				heap.push(0, s);
+			}
+		}
+
+		while (heap.size() != 0)
+		{
+			auto [dist, source] = heap.pop();
+
+			// Radix heap keeps stale entries
+			if (dist != distances[source])
+			{
+				continue;
+			}
+
+			if (source == target)
+			{
+				break;
+			}
+
+			for (uint32_t i = 0; i < graph[source].size(); ++i)
+			{
+				uint32_t destination = graph[source][i].vertex;
+				uint32_t edge = graph[source][i].edge;
+				distance_type distance = dist + graph.edges[edge].weight;
+
+				if (distance < distances[destination])
+				{
+					distances[destination] = distance;
+					heap.push(distance, destination);
+				}
+			}
+		}
+	};
+
+	if constexpr (is_integral_v<weight_type>)
+	{
+		radix_heap<uint32_t> heap;
+		search(heap);
+	}
+	else
+	{
+		indexed_heap<distance_type> heap(graph.size());
+		search(heap);
+	}
+
+	return distances;
+}
+
+template <weighted_graph_type T>
+auto dijkstra(T &graph, uint32_t index)
+{
+	vector<uint32_t> sources = {index};
+	return dijkstra_multi(graph, sources);
+}
+
+template <weighted_graph_type T>
+auto dijkstra_distance(T &graph, uint32_t source, uint32_t destination)
+{
+	vector<uint32_t> sources = {source};
+	return dijkstra_multi(graph, sources, destination)[destination];
+}
+
+// Out and in neighbour masks for the bitmask DPs below, at most 32 vertices
+pair<vector<uint32_t>, vector<uint32_t>> _hamiltonian_masks(vector<vector<uint32_t>> &graph)
+{
+	vector<uint32_t> out(graph.size(), 0), in(graph.size(), 0);
+
+	for (uint32_t i = 0; i < graph.size(); ++i)
+	{
+		for (uint32_t destination : graph[i])
+		{
+			out[i] |= 1u << destination;
+			in[destination] |= 1u << i;
+		}
+	}
+
+	return make_pair(out, in);
+}
+
+// Calls task(mask) on every non-empty mask of bits, a mask only after all masks with one bit less
+// Sequentially that is plain increasing order, with threads each popcount layer is split across the pool
+// Each worker unranks the first mask of its share of the layer and walks the rest with Gosper's hack
+template <typename FUNCTION>
+void _popcount_layers(uint32_t bits, uint32_t threads, FUNCTION &&task)
+{
+	uint64_t total = 1ull << bits;
+
+	if (threads <= 1)
+	{
+		for (uint64_t mask = 1; mask < total; ++mask)
+		{
+			task(mask);
+		}
+
+		return;
+	}
+
+	// binomial[n][k] = n choose k
+	vector<vector<uint64_t>> binomial(bits + 1, vector<uint64_t>(bits + 1, 0));
+
+	for (uint32_t n = 0; n <= bits; ++n)
+	{
+		binomial[n][0] = 1;
+
+		for (uint32_t k = 1; k <= n; ++k)
+		{
+			binomial[n][k] = binomial[n - 1][k - 1] + (k < n ? binomial[n - 1][k] : 0);
+		}
+	}
+
+	// The rank-th mask with layer bits set in increasing order (combinatorial number system)
+	auto unrank = [&](uint32_t layer, uint64_t rank) -> uint64_t
+	{
+		uint64_t mask = 0;
+		uint32_t top = bits;
+
+		for (uint32_t k = layer; k != 0; --k)
+		{
+			do
+			{
+				top -= 1;
+			} while (binomial[top][k] > rank);
+
+			mask |= 1ull << top;
+			rank -= binomial[top][k];
+		}
+
+		return mask;
+	};
+
+	thread_pool pool(threads);
+
+	for (uint32_t layer = 1; layer <= bits; ++layer)
+	{
+		uint64_t count = binomial[bits][layer];
+
+		pool.run(
+			[&](uint32_t worker)
+			{
+				uint64_t begin = count * worker / threads;
+				uint64_t end = count * (worker + 1) / threads;
+				uint64_t mask = begin < end ? unrank(layer, begin) : 0;
+
+				for (uint64_t rank = begin; rank < end; ++rank)
+				{
+					task(mask);
+
+					// Next larger mask with the same popcount
+					uint64_t low = mask & NEG(mask);
+					uint64_t ripple = mask + low;
+
+					mask = (((ripple ^ mask) >> 2) / low) | ripple;
+				}
+			});
+	}
+}
+
+// reach[mask] has bit v set when some path visits exactly mask and ends at v, O(2^n n)
+vector<uint32_t> hamiltonian_reach(vector<vector<uint32_t>> &graph, uint32_t threads = 1)
+{
+	uint32_t size = graph.size();
+	auto [out, in] = _hamiltonian_masks(graph);
+	vector<uint32_t> reach(1ull << size, 0);
+
+	_popcount_layers(size, threads,
+					 [&](uint32_t mask)
+					 {
+						 uint32_t ends = 0;
+
+						 for (uint32_t bits = mask; bits != 0; bits &= bits - 1)
+						 {
+							 uint32_t vertex = __builtin_ctz(bits);
+							 uint32_t rest = mask ^ (1u << vertex);
+
+							 if (rest == 0 || (reach[rest] & in[vertex]) != 0)
+							 {
+								 ends |= 1u << vertex;
+							 }
+						 }
+
+						 reach[mask] = ends;
+					 });
+
+	return reach;
+}
+
+// Vertices on the longest simple path
+uint32_t longest_hamiltonian_path(vector<vector<uint32_t>> &graph, uint32_t threads = 1)
+{
+	vector<uint32_t> reach = hamiltonian_reach(graph, threads);
+	uint32_t count = 0;
+
+	for (uint32_t mask = 0; mask < reach.size(); ++mask)
+	{
+		if (reach[mask] != 0)
+		{
+			count = MAX(count, (uint32_t)__builtin_popcount(mask));
+		}
+	}
+
+	return count;
+}
+
+uint8_t hamiltonian_path_exists(vector<vector<uint32_t>> &graph, uint32_t threads = 1)
+{
+	return graph.size() == 0 || hamiltonian_reach(graph, threads).back() != 0;
+}
+
+// Number of vertex sequences visiting every vertex once along edges, table of 2^n n counters
+uint64_t hamiltonian_path_count(vector<vector<uint32_t>> &graph, uint32_t threads = 1)
+{
+	uint32_t size = graph.size();
+	auto [out, in] = _hamiltonian_masks(graph);
+	vector<uint64_t> counts((1ull << size) * size, 0);
+	uint64_t total = 0;
+
+	_popcount_layers(size, threads,
+					 [&](uint32_t mask)
+					 {
+						 for (uint32_t bits = mask; bits != 0; bits &= bits - 1)
+						 {
+							 uint32_t vertex = __builtin_ctz(bits);
+							 uint32_t rest = mask ^ (1u << vertex);
+							 uint64_t count = rest == 0;
+
+							 for (uint32_t previous = rest & in[vertex]; previous != 0; previous &= previous - 1)
+							 {
+								 count += counts[(uint64_t)rest * size + __builtin_ctz(previous)];
+							 }
+
+							 counts[(uint64_t)mask * size + vertex] = count;
+						 }
+					 });
+
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		total += counts[((1ull << size) - 1) * size + i];
+	}
+
+	return total;
+}
+
+// Minimum cost Hamiltonian cycle, numeric_limits<COST>::max() marks a missing edge and is returned when there is no tour
+// Vertex 0 is fixed as the start, so the table covers 2^(n-1) (n-1) states
+template <typename COST>
+COST tsp(vector<vector<COST>> &costs, uint32_t threads = 1)
+{
+	constexpr COST none = numeric_limits<COST>::max();
+
+	uint32_t size = costs.size();
+	uint32_t bits = size - 1;
+	COST best = none;
+
+	if (size <= 1)
+	{
+		return 0;
+	}
+
+	// Vertex i + 1 is bit i
+	vector<COST> dp((1ull << bits) * bits, none);
+
+	_popcount_layers(bits, threads,
+					 [&](uint32_t mask)
+					 {
+						 for (uint32_t ends = mask; ends != 0; ends &= ends - 1)
+						 {
+							 uint32_t vertex = __builtin_ctz(ends);
+							 uint32_t rest = mask ^ (1u << vertex);
+							 COST result = rest == 0 ? costs[0][vertex + 1] : none;
+
+							 for (uint32_t previous = rest; previous != 0; previous &= previous - 1)
+							 {
+								 uint32_t index = __builtin_ctz(previous);
+								 COST cost = dp[(uint64_t)rest * bits + index];
+								 COST step = costs[index + 1][vertex + 1];
+
+								 if (cost != none && step != none)
+								 {
+									 result = MIN(result, cost + step);
+								 }
+							 }
+
+							 dp[(uint64_t)mask * bits + vertex] = result;
+						 }
+					 });
+
+	for (uint32_t i = 0; i < bits; ++i)
+	{
+		COST cost = dp[((1ull << bits) - 1) * bits + i];
+
+		if (cost != none && costs[i + 1][0] != none)
+		{
+			best = MIN(best, cost + costs[i + 1][0]);
+		}
+	}
+
+	return best;
+}
+
+// Functional graph, every vertex has one successor, so each component is a cycle with in-trees hanging off it
+// Tree vertices are numbered by an Euler tour of the in-forests, a level ancestor is then a binary search in one depth
+struct successor_graph
+{
+	vector<uint32_t> graph;
+	vector<vector<uint32_t>> backs;
+	vector<vector<uint32_t>> cycles;
+
+	// {cycle, position} for cycle vertices, cycles[c][p + 1] is the successor of cycles[c][p]
+	vector<pair<uint32_t, uint32_t>> cycle_info;
+
+	// First cycle vertex reached and the steps to it
+	vector<uint32_t> roots;
+	vector<uint32_t> depths;
+
+	// Euler tour of the in-trees, tour[tin[v]] = v and the subtree of v is [tin[v], tout[v])
+	vector<uint32_t> tin, tout, tour;
+
+	// Tins of each depth in increasing order, depth d is levels[level_offsets[d] .. level_offsets[d + 1])
+	vector<uint32_t> level_offsets;
+	vector<uint32_t> levels;
+
+	uint32_t size;
+
+	successor_graph(uint32_t n)
+	{
+		this->size = n;
+		this->graph = vector<uint32_t>(n);
+		this->backs = vector<vector<uint32_t>>(n);
+
+		this->cycle_info = vector<pair<uint32_t, uint32_t>>(n, {UINT32_MAX, UINT32_MAX});
+	}
+
+	void read()
+	{
+		for (uint32_t i = 0; i < this->size; ++i)
+		{
+			input(this->graph[i]);
+		}
+	}
+
+	void build()
+	{
+		vector<uint8_t> visited(this->size, 0);
+		vector<uint32_t> stack;
+
+		// Detect cycles, 1 while on the current walk and 2 once finished
+		for (uint32_t i = 0; i < this->size; ++i)
+		{
+			uint32_t current = i;
+
+			while (visited[current] == 0)
+			{
+				visited[current] = 1;
+				stack.push_back(current);
+
+				current = this->graph[current];
+			}
+
+			if (visited[current] == 1)
+			{
+				uint32_t start = find(stack.begin(), stack.end(), current) - stack.begin();
+
+				for (uint32_t j = start; j < stack.size(); ++j)
+				{
+					this->cycle_info[stack[j]] = {this->cycles.size(), j - start};
+				}
+
+				this->cycles.push_back(vector<uint32_t>(stack.begin() + start, stack.end()));
+			}
+
+			for (uint32_t vertex : stack)
+			{
+				visited[vertex] = 2;
+			}
+
+			stack.clear();
+		}
+
+		// Build forests
+		for (uint32_t i = 0; i < this->size; ++i)
+		{
+			this->backs[this->graph[i]].push_back(i);
+		}
+
+		this->roots = vector<uint32_t>(this->size);
+		this->depths = vector<uint32_t>(this->size, 0);
+		this->tin = vector<uint32_t>(this->size);
+		this->tout = vector<uint32_t>(this->size);
+		this->tour = vector<uint32_t>(this->size);
+
+		uint32_t timer = 0;
+		std::stack<array<uint32_t, 2>> st;
+
+		for (auto &cycle : this->cycles)
+		{
+			for (uint32_t root : cycle)
+			{
+				st.push({root, 0});
+				this->roots[root] = root;
+				this->tour[timer] = root;
+				this->tin[root] = timer++;
+
+				while (st.size() != 0)
+				{
+					uint32_t source = st.top()[0];
+					uint32_t &start = st.top()[1];
+
+					// Skip the predecessor on the cycle
+					while (start < this->backs[source].size() && this->cycle_info[this->backs[source][start]].first != UINT32_MAX)
+					{
+						start += 1;
+					}
+
+					if (start == this->backs[source].size())
+					{
+						this->tout[source] = timer;
+						st.pop();
+
+						continue;
+					}
+
+					uint32_t destination = this->backs[source][start];
+
+					start += 1;
+
+					this->roots[destination] = root;
+					this->depths[destination] = this->depths[source] + 1;
+					this->tour[timer] = destination;
+					this->tin[destination] = timer++;
+
+					st.push({destination, 0});
+				}
+			}
+		}
+
+		// Counting sort of the tour by depth keeps each depth in tin order
+		uint32_t deepest = *max_element(this->depths.begin(), this->depths.end());
+
+		this->level_offsets = vector<uint32_t>(deepest + 2, 0);
+		this->levels = vector<uint32_t>(this->size);
+
+		for (uint32_t i = 0; i < this->size; ++i)
+		{
+			this->level_offsets[this->depths[i] + 1]++;
+		}
+
+		for (uint32_t i = 0; i <= deepest; ++i)
+		{
+			this->level_offsets[i + 1] += this->level_offsets[i];
+		}
+
+		vector<uint32_t> next(this->level_offsets.begin(), this->level_offsets.end() - 1);
+
+		for (uint32_t i = 0; i < this->size; ++i)
+		{
+			this->levels[next[this->depths[this->tour[i]]]++] = i;
+		}
+	}
+
+	uint32_t cycle_entry(uint32_t vertex)
+	{
+		return this->roots[vertex];
+	}
+
+	// Ancestor of vertex in its in-tree at depth, the last tin of that depth not after tin[vertex]
+	uint32_t _level_ancestor(uint32_t vertex, uint32_t depth)
+	{
+		auto begin = this->levels.begin() + this->level_offsets[depth];
+		auto end = this->levels.begin() + this->level_offsets[depth + 1];
+
+		return this->tour[*(upper_bound(begin, end, this->tin[vertex]) - 1)];
+	}
+
+	// O(1) once the walk reaches the cycle, O(log n) inside a tree
+	uint32_t kth(uint32_t vertex, uint64_t k)
+	{
+		if (k < this->depths[vertex])
+		{
+			return this->_level_ancestor(vertex, this->depths[vertex] - k);
+		}
+
+		auto [cycle, position] = this->cycle_info[this->roots[vertex]];
+		uint64_t length = this->cycles[cycle].size();
+
+		return this->cycles[cycle][(position + (k - this->depths[vertex]) % length) % length];
+	}
+
+	// Steps from source to destination, UINT32_MAX when destination is never reached
+	uint32_t distance(uint32_t source, uint32_t destination)
+	{
+		if (this->cycle_info[destination].first == UINT32_MAX)
+		{
+			if (this->tin[destination] <= this->tin[source] && this->tin[source] < this->tout[destination])
+			{
+				return this->depths[source] - this->depths[destination];
+			}
+
+			return UINT32_MAX;
+		}
+
+		auto [cycle, position] = this->cycle_info[this->roots[source]];
+
+		if (cycle != this->cycle_info[destination].first)
+		{
+			return UINT32_MAX;
+		}
+
+		uint32_t length = this->cycles[cycle].size();
+
+		return this->depths[source] + (this->cycle_info[destination].second + length - position) % length;
+	}
+};
+
+struct sat
+{
+	csr_directed_graph dag;
+	vector<uint8_t> assignment;
+
+	sat(uint32_t size)
+	{
+		this->dag = csr_directed_graph(size * 2);
+	}
+
+	void add(uint32_t va, uint8_t sa, uint32_t vb, uint8_t sb)
+	{
+		auto var = [](uint32_t v, uint8_t s) { return (v << 1) + s; };
+
+		this->dag.add_edge(var(va, !sa), var(vb, sb));
+		this->dag.add_edge(var(vb, !sb), var(va, sa));
+	}
+
+	// Fills assignment when satisfiable, a variable is true when its true literal comes later in topological order
+	uint8_t satisfiable()
+	{
+		uint32_t size = this->dag.size() / 2;
+
+		this->dag.build();
+
+		auto [ids, count] = dfs_scc(this->dag);
+		auto var = [](uint32_t v, uint8_t s) { return (v << 1) + s; };
+
+		this->assignment = vector<uint8_t>(size, 0);
+
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			if (ids[var(i, 0)] == ids[var(i, 1)])
+			{
+				return 0;
+			}
+
+			this->assignment[i] = ids[var(i, 1)] > ids[var(i, 0)];
+		}
+
+		return 1;
+	}
+};
+
+// Hopcroft-Karp, side[v] is 1 for left vertices, edges inside one side are ignored, O(E sqrt(V))
+// Returns the matching size and mate[v], UINT32_MAX for unmatched vertices
+template <graph_type T>
+	requires(!directed_graph_type<T>)
+pair<uint32_t, vector<uint32_t>> hopcroft_karp(T &graph, vector<uint8_t> &side)
+{
+	uint32_t size = graph.size();
+
+	vector<uint32_t> mate(size, UINT32_MAX);
+	vector<uint32_t> distances(size);
+	vector<uint32_t> current(size);
+	vector<uint32_t> qu(size);
+	vector<uint32_t> path;
+
+	uint32_t matched = 0;
+
+	// Greedy start, usually most of the matching
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		for (uint32_t j = 0; j < graph[i].size() && side[i] == 1; ++j)
+		{
+			uint32_t destination = graph[i][j].vertex;
+
+			if (side[destination] == 0 && mate[destination] == UINT32_MAX)
+			{
+				mate[i] = destination;
+				mate[destination] = i;
+				matched += 1;
+
+				break;
+			}
+		}
+	}
+
+	while (true)
+	{
+		uint32_t head = 0, tail = 0;
+		uint32_t limit = UINT32_MAX;
+
+		// Layers over left vertices, stopping at the first layer that sees a free right vertex
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			distances[i] = UINT32_MAX;
+
+			if (side[i] == 1 && mate[i] == UINT32_MAX)
+			{
+				distances[i] = 0;
+				qu[tail++] = i;
+			}
+		}
+
+		while (head != tail)
+		{
+			uint32_t vertex = qu[head++];
+
+			if (distances[vertex] >= limit)
+			{
+				break;
+			}
+
+			for (auto [destination, edge] : graph[vertex])
+			{
+				uint32_t next = mate[destination];
+
+				if (side[destination] == 1)
+				{
+					continue;
+				}
+
+				if (next == UINT32_MAX)
+				{
+					limit = MIN(limit, distances[vertex] + 1);
+				}
+				else if (distances[next] == UINT32_MAX)
+				{
+					distances[next] = distances[vertex] + 1;
+					qu[tail++] = next;
+				}
+			}
+		}
+
+		if (limit == UINT32_MAX)
+		{
+			break;
+		}
+
+		fill(current.begin(), current.end(), 0);
+
+		// Vertex disjoint shortest augmenting paths, path holds left vertices and current their chosen edge
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			if (side[i] == 0 || mate[i] != UINT32_MAX || distances[i] != 0)
+			{
+				continue;
+			}
+
+			path.push_back(i);
+
+			while (path.size() != 0)
+			{
+				uint32_t vertex = path.back();
+
+				if (current[vertex] == graph[vertex].size())
+				{
+					distances[vertex] = UINT32_MAX;
+					path.pop_back();
+
+					if (path.size() != 0)
+					{
+						current[path.back()] += 1;
+					}
+
+					continue;
+				}
+
+				uint32_t destination = graph[vertex][current[vertex]].vertex;
+				uint32_t next = mate[destination];
+
+				if (side[destination] == 1)
+				{
+					current[vertex] += 1;
+				}
+				else if (next == UINT32_MAX && distances[vertex] + 1 == limit)
+				{
+					for (uint32_t left : path)
+					{
+						uint32_t right = graph[left][current[left]].vertex;
+
+						mate[left] = right;
+						mate[right] = left;
+					}
+
+					// Used up for this phase
+					for (uint32_t left : path)
+					{
+						distances[left] = UINT32_MAX;
+					}
+
+					matched += 1;
+					path.clear();
+				}
+				else if (next != UINT32_MAX && distances[next] == distances[vertex] + 1)
+				{
+					path.push_back(next);
+				}
+				else
+				{
+					current[vertex] += 1;
+				}
+			}
+		}
+	}
+
+	return make_pair(matched, mate);
+}
+
+// Minimum vertex cover from a maximum matching (Konig), cover[v] is 1 for vertices in the cover
+template <graph_type T>
+	requires(!directed_graph_type<T>)
+vector<uint8_t> vertex_cover(T &graph, vector<uint8_t> &side, vector<uint32_t> &mate)
+{
+	vector<uint8_t> visited(graph.size(), 0);
+	vector<uint8_t> cover(graph.size(), 0);
+	queue<uint32_t> qu;
+
+	// Alternating BFS from free left vertices, out along unmatched edges and back along matched ones
+	for (uint32_t i = 0; i < graph.size(); ++i)
+	{
+		if (side[i] == 1 && mate[i] == UINT32_MAX)
+		{
+			visited[i] = 1;
+			qu.push(i);
+		}
+	}
+
+	while (qu.size() != 0)
+	{
+		uint32_t vertex = qu.front();
+
+		qu.pop();
+
+		for (auto [destination, edge] : graph[vertex])
+		{
+			if (side[destination] == 1 || visited[destination] || destination == mate[vertex])
+			{
+				continue;
+			}
+
+			visited[destination] = 1;
+
+			if (mate[destination] != UINT32_MAX && visited[mate[destination]] == 0)
+			{
+				visited[mate[destination]] = 1;
+				qu.push(mate[destination]);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < graph.size(); ++i)
+	{
+		cover[i] = side[i] == 1 ? !visited[i] : visited[i];
+	}
+
+	return cover;
+}
+
+// Residual network, arc 2i is edge i and arc 2i + 1 its reverse, so arc ^ 1 is always the paired arc
+struct flow_graph
+{
+	struct edge
+	{
+		uint32_t source, destination;
+		int64_t capacity;
+		int64_t cost;
+	};
+
+	struct arc
+	{
+		uint32_t destination;
+		int64_t capacity;
+		int64_t cost;
+	};
+
+	// Edge is the residual arc index
+	struct list
+	{
+		uint32_t vertex;
+		uint32_t edge;
+	};
+
+	uint32_t vertex_count;
+	uint32_t edge_count;
+
+	vector<edge> edges;
+	vector<arc> arcs;
+	vector<uint32_t> offsets;
+	vector<list> targets;
+
+	span<list> operator[](uint32_t index)
+	{
+		return span<list>(this->targets.data() + this->offsets[index], this->offsets[index + 1] - this->offsets[index]);
+	}
+
+	flow_graph(uint32_t vertex_count)
+	{
+		this->vertex_count = vertex_count;
+		this->edge_count = 0;
+	}
+
+	void add_edge(uint32_t source, uint32_t destination, int64_t capacity, int64_t cost = 0)
+	{
+		this->edges.push_back({source, destination, capacity, cost});
+		this->edge_count += 1;
+	}
+
+	void build()
+	{
+		this->arcs = vector<arc>(this->edge_count * 2);
+		this->offsets = vector<uint32_t>(this->vertex_count + 1, 0);
+
+		for (uint32_t i = 0; i < this->edge_count; ++i)
+		{
+			this->arcs[i * 2] = {this->edges[i].destination, this->edges[i].capacity, this->edges[i].cost};
+			this->arcs[i * 2 + 1] = {this->edges[i].source, 0, -this->edges[i].cost};
+
+			this->offsets[this->edges[i].source + 1]++;
+			this->offsets[this->edges[i].destination + 1]++;
+		}
+
+		for (uint32_t i = 0; i < this->vertex_count; ++i)
+		{
+			this->offsets[i + 1] += this->offsets[i];
+		}
+
+		vector<uint32_t> next(this->offsets.begin(), this->offsets.end() - 1);
+		this->targets = vector<list>(this->edge_count * 2);
+
+		for (uint32_t i = 0; i < this->edge_count; ++i)
+		{
+			this->targets[next[this->edges[i].source]++] = {this->edges[i].destination, i * 2};
+			this->targets[next[this->edges[i].destination]++] = {this->edges[i].source, i * 2 + 1};
+		}
+	}
+
+	// Flow currently sent along edge
+	int64_t flow(uint32_t edge)
+	{
+		return this->arcs[edge * 2 + 1].capacity;
+	}
+
+	// Drops all flow, back to the original capacities
+	void reset()
+	{
+		for (uint32_t i = 0; i < this->edge_count; ++i)
+		{
+			this->arcs[i * 2].capacity = this->edges[i].capacity;
+			this->arcs[i * 2 + 1].capacity = 0;
+		}
+	}
+
+	uint32_t size()
+	{
+		return this->vertex_count;
+	}
+};
+
+// Dinic, BFS level graph then blocking flow by DFS with current arcs, O(V^2 E) and O(E sqrt(V)) on unit networks
+int64_t maxflow(flow_graph &graph, uint32_t source, uint32_t sink)
+{
+	vector<uint32_t> levels(graph.size());
+	vector<uint32_t> current(graph.size());
+	vector<uint32_t> qu(graph.size());
+	vector<uint32_t> path;
+
+	int64_t flow = 0;
+
+	if (source == sink)
+	{
+		return 0;
+	}
+
+	while (true)
+	{
+		uint32_t head = 0, tail = 0;
+
+		fill(levels.begin(), levels.end(), UINT32_MAX);
+		levels[source] = 0;
+		qu[tail++] = source;
+
+		while (head != tail && levels[sink] == UINT32_MAX)
+		{
+			uint32_t vertex = qu[head++];
+
+			for (auto [destination, arc] : graph[vertex])
 			{
-				distances[destination] = weight + distances[source];
-				pq.push({distances[destination], destination});
+				if (graph.arcs[arc].capacity > 0 && levels[destination] == UINT32_MAX)
+				{
+					levels[destination] = levels[vertex] + 1;
+					qu[tail++] = destination;
+				}
 			}
 		}
-	}
-
-	return distances;
-}
 
-uint32_t longest_hamiltonian_aux(vector<vector<uint32_t>> &graph, map<pair<uint32_t, uint32_t>, uint32_t> &cache, uint32_t visited,
-								 uint32_t index)
-{
-	uint32_t count = 0;
+		if (levels[sink] == UINT32_MAX)
+		{
+			break;
+		}
 
-	if (cache.contains({index, visited}))
-	{
-		return cache[{index, visited}];
-	}
+		copy(graph.offsets.begin(), graph.offsets.end() - 1, current.begin());
 
-	for (uint32_t i = 0; i < graph[index].size(); ++i)
-	{
-		uint32_t destination = graph[index][i];
+		uint32_t vertex = source;
+		path.clear();
 
-		if ((visited & (1 << destination)) == 0)
+		while (true)
 		{
-			count = MAX(count, longest_hamiltonian_aux(graph, cache, visited | (1 << destination), destination));
-		}
-	}
+			if (vertex == sink)
+			{
+				int64_t increment = INT64_MAX;
+				uint32_t saturated = 0;
 
-	count += 1;
-	cache[{index, visited}] = count;
+				for (uint32_t arc : path)
+				{
+					increment = MIN(increment, graph.arcs[arc].capacity);
+				}
 
-	return count;
-}
+				for (uint32_t i = path.size(); i != 0; --i)
+				{
+					graph.arcs[path[i - 1]].capacity -= increment;
+					graph.arcs[path[i - 1] ^ 1].capacity += increment;
 
-uint32_t longest_hamiltonian_path(vector<vector<uint32_t>> &graph)
-{
-	uint32_t size = graph.size();
-	uint32_t count = 0;
+					if (graph.arcs[path[i - 1]].capacity == 0)
+					{
+						saturated = i - 1;
+					}
+				}
 
-	map<pair<uint32_t, uint32_t>, uint32_t> cache;
+				flow += increment;
 
-	for (uint32_t i = 0; i < size; ++i)
-	{
-		count = MAX(count, longest_hamiltonian_aux(graph, cache, (1 << i), i));
+				// Resume from the tail of the first saturated arc
+				vertex = graph.arcs[path[saturated] ^ 1].destination;
+				path.resize(saturated);
+
+				continue;
+			}
+
+			uint32_t end = graph.offsets[vertex + 1];
+
+			while (current[vertex] != end)
+			{
+				auto [destination, arc] = graph.targets[current[vertex]];
+
+				if (graph.arcs[arc].capacity > 0 && levels[destination] == levels[vertex] + 1)
+				{
+					break;
+				}
+
+				current[vertex] += 1;
+			}
+
+			if (current[vertex] != end)
+			{
+				path.push_back(graph.targets[current[vertex]].edge);
+				vertex = graph.targets[current[vertex]].vertex;
+
+				continue;
+			}
+
+			// Dead end, remove it from the level graph and retreat
+			levels[vertex] = UINT32_MAX;
+
+			if (path.size() == 0)
+			{
+				break;
+			}
+
+			vertex = graph.arcs[path.back() ^ 1].destination;
+			path.pop_back();
+			current[vertex] += 1;
+		}
 	}
 
-	return count;
+	return flow;
 }
 
-struct successor_graph
+// Highest-label push-relabel with gap and global relabeling, O(V^2 sqrt(E))
+// Ends with a flow, not a preflow, excess that cannot reach the sink is pushed back to the source
+int64_t push_relabel(flow_graph &graph, uint32_t source, uint32_t sink)
 {
-	vector<uint32_t> graph;
-	vector<vector<uint32_t>> backs;
-	vector<vector<uint32_t>> cycles;
+	uint32_t size = graph.size();
 
-	vector<pair<uint32_t, uint32_t>> cycle_info;
+	vector<uint32_t> heights(size, 0);
+	vector<uint32_t> current(size);
+	vector<uint32_t> counts(size * 2 + 1);
+	vector<uint32_t> qu(size);
+	vector<uint8_t> visited(size);
+	vector<int64_t> excess(size, 0);
+	vector<vector<uint32_t>> active(size * 2 + 1);
 
-	uint32_t size;
+	uint32_t highest = 0;
+	uint64_t work = 0;
 
-	successor_graph(uint32_t n)
+	if (source == sink)
 	{
-		this->size = n;
-		this->graph = vector<uint32_t>(n);
-		this->backs = vector<vector<uint32_t>>(n);
-
-		this->cycle_info = vector<pair<uint32_t, uint32_t>>(n, {UINT32_MAX, UINT32_MAX});
+		return 0;
 	}
 
-	void read()
+	auto activate = [&](uint32_t vertex)
 	{
-		for (uint32_t i = 0; i < this->size; ++i)
+		if (vertex != source && vertex != sink)
 		{
-			cin >> this->graph[i];
+			active[heights[vertex]].push_back(vertex);
+			highest = MAX(highest, heights[vertex]);
 		}
-	}
+	};
 
-	void build()
+	auto push = [&](uint32_t vertex, uint32_t arc, int64_t amount)
 	{
-		vector<uint8_t> visited(this->size, 0);
-		vector<uint32_t> stack;
+		uint32_t destination = graph.arcs[arc].destination;
 
-		// Detect cycles
-		for (uint32_t i = 0; i < this->size; ++i)
+		if (excess[destination] == 0)
 		{
-			vector<uint32_t> cycle;
-			uint32_t current = i;
+			activate(destination);
+		}
 
-			if (visited[i] != 0)
-			{
-				continue;
-			}
+		graph.arcs[arc].capacity -= amount;
+		graph.arcs[arc ^ 1].capacity += amount;
+		excess[vertex] -= amount;
+		excess[destination] += amount;
+	};
 
-			while (visited[current] == 0)
-			{
-				visited[current] = 1;
-				stack.push_back(current);
+	// Exact distances to the sink by reverse BFS, and size plus the distance to the source for vertices cut off from the sink
+	// A valid labeling bounds both from below, so no label decreases, vertices reaching neither hold no excess and park at size * 2
+	auto global_relabel = [&]()
+	{
+		uint32_t head = 0, tail = 0;
 
-				current = this->graph[current];
-			}
+		fill(visited.begin(), visited.end(), 0);
+
+		for (uint32_t root : {sink, source})
+		{
+			visited[root] = 1;
+			heights[root] = root == sink ? 0 : size;
+			qu[tail++] = root;
 
-			while (stack.back() != current)
+			while (head != tail)
 			{
-				cycle.push_back(stack.back());
-				stack.pop_back();
+				uint32_t vertex = qu[head++];
+
+				for (auto [destination, arc] : graph[vertex])
+				{
+					if (graph.arcs[arc ^ 1].capacity > 0 && visited[destination] == 0 && destination != source)
+					{
+						visited[destination] = 1;
+						heights[destination] = heights[vertex] + 1;
+						qu[tail++] = destination;
+					}
+				}
 			}
+		}
 
-			cycle.push_back(current);
+		fill(counts.begin(), counts.end(), 0);
+		highest = 0;
 
-			this->cycles.push_back(cycle);
-			stack.clear();
+		for (uint32_t i = 0; i < size * 2 + 1; ++i)
+		{
+			active[i].clear();
 		}
 
-		for (uint32_t i = 0; i < this->cycles.size(); ++i)
+		for (uint32_t i = 0; i < size; ++i)
 		{
-			for (uint32_t j = 0; j < this->cycles[i].size(); ++j)
+			heights[i] = visited[i] ? heights[i] : size * 2;
+			counts[heights[i]] += 1;
+			current[i] = graph.offsets[i];
+
+			if (excess[i] > 0)
 			{
-				this->cycle_info[this->cycles[i][j]] = {i, j};
+				activate(i);
 			}
 		}
+	};
 
-		// Build forests
-		for (uint32_t i = 0; i < this->size; ++i)
+	heights[source] = size;
+
+	for (auto [destination, arc] : graph[source])
+	{
+		if (graph.arcs[arc].capacity > 0)
 		{
-			this->backs[this->graph[i]].push_back(i);
+			push(source, arc, graph.arcs[arc].capacity);
 		}
+	}
 
-		for (uint32_t i = 0; i < this->size; ++i)
+	global_relabel();
+
+	while (true)
+	{
+		while (active[highest].size() == 0 && highest != 0)
+		{
+			highest -= 1;
+		}
+
+		if (active[highest].size() == 0)
+		{
+			break;
+		}
+
+		uint32_t vertex = active[highest].back();
+		active[highest].pop_back();
+
+		// A gap may have lifted it after it was queued
+		if (heights[vertex] != highest)
+		{
+			activate(vertex);
+			continue;
+		}
+
+		uint32_t end = graph.offsets[vertex + 1];
+
+		while (excess[vertex] > 0)
 		{
-			for (uint32_t j = 0; j < this->backs[i].size(); ++j)
+			if (current[vertex] == end)
 			{
-				uint32_t next = this->backs[i][j];
+				uint32_t height = heights[vertex];
+				uint32_t label = size * 2;
 
-				if (this->cycle_info[next].first != UINT32_MAX)
+				for (auto [destination, arc] : graph[vertex])
 				{
-					continue;
+					if (graph.arcs[arc].capacity > 0)
+					{
+						label = MIN(label, heights[destination] + 1);
+					}
 				}
-			}
-		}
-	}
-};
-
-struct sat
-{
-	directed_graph dag;
 
-	sat(uint32_t size)
-	{
-		this->dag = directed_graph(size * 2);
-	}
+				work += end - graph.offsets[vertex] + 12;
 
-	void add(uint32_t va, uint8_t sa, uint32_t vb, uint8_t sb)
-	{
-		auto var = [](uint32_t v, uint8_t s) { return (v << 1) + s; };
+				counts[height] -= 1;
+				counts[label] += 1;
+				heights[vertex] = label;
+				current[vertex] = graph.offsets[vertex];
 
-		this->dag.add_edge(var(va, !sa), var(vb, sb));
-		this->dag.add_edge(var(vb, !sb), var(va, sa));
-	}
+				// Nothing is left at height, so everything above it up to size is cut off from the sink
+				if (counts[height] == 0 && height < size)
+				{
+					for (uint32_t i = 0; i < size; ++i)
+					{
+						if (heights[i] > height && heights[i] < size)
+						{
+							counts[heights[i]] -= 1;
+							counts[size] += 1;
+							heights[i] = size;
+						}
+					}
+				}
 
-	uint8_t satisfiable()
-	{
-		uint32_t size = this->dag.size() / 2;
-		vector<uint32_t> dsu(size * 2);
-		vector<vector<uint32_t>> components;
-		uint32_t count = 0;
+				continue;
+			}
 
-		this->dag.build();
-		components = dfs_components(this->dag);
+			auto [destination, arc] = graph.targets[current[vertex]];
 
-		for (auto &comp : components)
-		{
-			for (uint32_t i = 0; i < comp.size(); ++i)
+			if (graph.arcs[arc].capacity > 0 && heights[vertex] == heights[destination] + 1)
 			{
-				dsu[comp[0]] = count;
+				push(vertex, arc, MIN(excess[vertex], graph.arcs[arc].capacity));
 			}
+			else
+			{
+				current[vertex] += 1;
+			}
+		}
 
-			count += 1;
+		if (work > size * 12 + graph.arcs.size() * 2)
+		{
+			global_relabel();
+			work = 0;
 		}
+	}
 
-		auto var = [](uint32_t v, uint8_t s) { return (v << 1) + s; };
+	return excess[sink];
+}
 
-		for (uint32_t i = 0; i < size; ++i)
+// Source side of a minimum cut, read from the residual network after any max flow
+vector<uint8_t> mincut(flow_graph &graph, uint32_t source)
+{
+	vector<uint8_t> side(graph.size(), 0);
+	queue<uint32_t> qu;
+
+	side[source] = 1;
+	qu.push(source);
+
+	while (qu.size() != 0)
+	{
+		uint32_t vertex = qu.front();
+
+		qu.pop();
+
+		for (auto [destination, arc] : graph[vertex])
 		{
-			if (dsu[var(i, 0)] == dsu[var(i, 1)])
+			if (graph.arcs[arc].capacity > 0 && side[destination] == 0)
 			{
-				return 0;
+				side[destination] = 1;
+				qu.push(destination);
 			}
 		}
-
-		return 1;
 	}
-};
 
-struct flow_graph
-{
-	struct edge
-	{
-		uint32_t source, destination;
-		int32_t capacity;
-		int32_t cost;
-	};
+	return side;
+}
 
-	struct list
-	{
-		uint32_t vertex;
-		uint32_t edge;
-	};
+// Successive shortest paths on reduced costs, Bellman-Ford once if any cost is negative and Dijkstra afterwards
+// Costs must not form a negative cycle
+auto mincostflow(flow_graph &graph, uint32_t source, uint32_t sink, int64_t demand)
+{
+	uint32_t size = graph.size();
 
-	uint32_t vertex_count;
-	uint32_t edge_count;
+	vector<int64_t> potentials(size, 0);
+	vector<int64_t> distances(size);
+	vector<uint32_t> parent(size);
+	vector<uint8_t> flags(size);
+	indexed_heap<int64_t> heap(size);
 
-	vector<edge> edges;
-	vector<vector<list>> adjlist;
-	vector<vector<int32_t>> capacities;
-	vector<vector<int32_t>> costs;
+	uint8_t negative = 0;
 
-	vector<list> &operator[](uint32_t index)
+	for (auto &arc : graph.arcs)
 	{
-		return adjlist[index];
+		negative |= arc.capacity > 0 && arc.cost < 0;
 	}
 
-	flow_graph(uint32_t vertex_count)
+	if (negative)
 	{
-		this->vertex_count = vertex_count;
-		this->edge_count = 0;
-		this->capacities = vector<vector<int32_t>>(this->vertex_count, vector<int32_t>(vector<int32_t>(this->vertex_count, 0)));
-		this->costs = vector<vector<int32_t>>(this->vertex_count, vector<int32_t>(vector<int32_t>(this->vertex_count, 0)));
-	}
+		queue<uint32_t> qu;
 
-	void add_edge(uint32_t source, uint32_t destination, int32_t capacity, int32_t cost = 0)
-	{
-		this->edges.push_back({source, destination, capacity, cost});
-		this->edge_count += 1;
-	}
+		fill(potentials.begin(), potentials.end(), INT64_MAX);
+		fill(flags.begin(), flags.end(), 0);
 
-	void build()
-	{
-		this->adjlist = vector<vector<list>>(this->vertex_count);
+		potentials[source] = 0;
+		flags[source] = 1;
+		qu.push(source);
 
-		for (uint32_t i = 0; i < this->edge_count; ++i)
+		while (qu.size() != 0)
 		{
-			this->adjlist[this->edges[i].source].push_back({this->edges[i].destination, i});
-			this->adjlist[this->edges[i].destination].push_back({this->edges[i].source, i});
+			uint32_t vertex = qu.front();
+
+			qu.pop();
+			flags[vertex] = 0;
 
-			this->capacities[this->edges[i].source][this->edges[i].destination] = this->edges[i].capacity;
-			this->capacities[this->edges[i].destination][this->edges[i].source] = 0;
+			for (auto [destination, arc] : graph[vertex])
+			{
+				if (graph.arcs[arc].capacity > 0 && potentials[vertex] + graph.arcs[arc].cost < potentials[destination])
+				{
+					potentials[destination] = potentials[vertex] + graph.arcs[arc].cost;
 
-			this->costs[this->edges[i].source][this->edges[i].destination] = this->edges[i].cost;
-			this->costs[this->edges[i].destination][this->edges[i].source] = -this->edges[i].cost;
+					if (flags[destination] == 0)
+					{
+						flags[destination] = 1;
+						qu.push(destination);
+					}
+				}
+			}
 		}
-	}
 
-	uint32_t size()
-	{
-		return this->vertex_count;
+		// Unreachable vertices stay unreachable, their potential is never read through a residual arc
+		for (int64_t &potential : potentials)
+		{
+			potential = potential == INT64_MAX ? 0 : potential;
+		}
 	}
-};
 
-auto mincostflow(flow_graph &graph, uint32_t source, uint32_t sink, uint32_t demand)
-{
-	auto shortest_path = [&]()
+	int64_t flow = 0;
+	int64_t cost = 0;
+
+	while (flow < demand)
 	{
-		vector<uint32_t> path(graph.size(), UINT32_MAX);
-		vector<int32_t> distances(graph.size(), INT32_MAX);
-		vector<uint8_t> queued(graph.size(), 0);
-		queue<uint32_t> qu;
+		fill(distances.begin(), distances.end(), INT64_MAX);
+		fill(flags.begin(), flags.end(), 0);
 
 		distances[source] = 0;
-		path[source] = source;
-		queued[source] = 1;
-		qu.push(source);
+		heap.push(0, source);
 
-		while (qu.size() != 0)
+		while (heap.size() != 0)
 		{
-			uint32_t current = qu.front();
+			auto [dist, vertex] = heap.pop();
 
-			for (uint32_t i = 0; i < graph[current].size(); ++i)
+			flags[vertex] = 1;
+
+			if (vertex == sink)
 			{
-				uint32_t next = graph[current][i].vertex;
+				break;
+			}
 
-				if (graph.capacities[current][next] > 0)
+			for (auto [destination, arc] : graph[vertex])
+			{
+				if (graph.arcs[arc].capacity > 0 && flags[destination] == 0)
 				{
-					if (distances[next] > distances[current] + graph.costs[current][next])
-					{
-						distances[next] = distances[current] + graph.costs[current][next];
-						path[next] = current;
+					int64_t distance = dist + graph.arcs[arc].cost + potentials[vertex] - potentials[destination];
 
-						if (queued[next] == 0)
-						{
-							queued[next] = 1;
-							qu.push(next);
-						}
+					if (distance < distances[destination])
+					{
+						distances[destination] = distance;
+						parent[destination] = arc;
+						heap.push(distance, destination);
 					}
 				}
 			}
-
-			queued[current] = 0;
-			qu.pop();
 		}
 
-		return make_pair(path, distances);
-	};
-
-	uint32_t flow = 0;
-	uint32_t cost = 0;
-
-	while (flow < demand)
-	{
-		auto [parent, distances] = shortest_path();
-		uint32_t current = sink;
-		int32_t increment = INT32_MAX;
+		heap.clear();
 
-		if (parent[sink] == UINT32_MAX)
+		if (distances[sink] == INT64_MAX)
 		{
 			break;
 		}
 
+		// Capping at the sink distance keeps reduced costs non-negative for vertices the search stopped short of
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			potentials[i] += MIN(distances[i], distances[sink]);
+		}
+
+		uint32_t current = sink;
+		int64_t increment = demand - flow;
+
 		while (current != source)
 		{
-			increment = MIN(increment, graph.capacities[parent[current]][current]);
-			current = parent[current];
+			increment = MIN(increment, graph.arcs[parent[current]].capacity);
+			current = graph.arcs[parent[current] ^ 1].destination;
 		}
 
 		flow += increment;
-		cost += increment * distances[sink];
+		cost += increment * (potentials[sink] - potentials[source]);
 
 		current = sink;
 
 		while (current != source)
 		{
-			graph.capacities[parent[current]][current] -= increment;
-			graph.capacities[current][parent[current]] += increment;
-			current = parent[current];
+			graph.arcs[parent[current]].capacity -= increment;
+			graph.arcs[parent[current] ^ 1].capacity += increment;
+			current = graph.arcs[parent[current] ^ 1].destination;
 		}
 	}
 
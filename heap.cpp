@@ -0,0 +1,181 @@
+#include "cp.h"
+
+// Monotone priority queue on unsigned keys, every pushed key must be >= the last popped key
+template <typename VALUE = uint32_t>
+struct radix_heap
+{
+	array<vector<pair<uint64_t, VALUE>>, 65> buckets;
+	uint64_t last = 0;
+	uint32_t count = 0;
+
+	uint32_t _bucket(uint64_t key)
+	{
+		return key == this->last ? 0 : 64 - __builtin_clzll(key ^ this->last);
+	}
+
+	void push(uint64_t key, VALUE value)
+	{
+		this->buckets[this->_bucket(key)].push_back({key, value});
+		this->count += 1;
+	}
+
+	pair<uint64_t, VALUE> pop()
+	{
+		if (this->buckets[0].size() == 0)
+		{
+			uint32_t index = 1;
+
+			while (this->buckets[index].size() == 0)
+			{
+				index += 1;
+			}
+
+			// Everything in the bucket shares the bits above index, so it spreads into lower buckets
+			this->last = min_element(this->buckets[index].begin(), this->buckets[index].end())->first;
+
+			for (auto &entry : this->buckets[index])
+			{
+				this->buckets[this->_bucket(entry.first)].push_back(entry);
+			}
+
+			this->buckets[index].clear();
+		}
+
+		pair<uint64_t, VALUE> top = this->buckets[0].back();
+
+		this->buckets[0].pop_back();
+		this->count -= 1;
+
+		return top;
+	}
+
+	uint32_t size()
+	{
+		return this->count;
+	}
+};
+
+// D-ary heap over items [0, size) with decrease-key, each item is stored at most once
+template <typename KEY, uint32_t ARITY = 4>
+struct indexed_heap
+{
+	vector<KEY> keys;
+	vector<uint32_t> positions;
+	vector<uint32_t> heap;
+
+	indexed_heap(uint32_t size)
+	{
+		this->keys.resize(size);
+		this->positions.resize(size, UINT32_MAX);
+	}
+
+	void _sift_up(uint32_t position)
+	{
+		uint32_t item = this->heap[position];
+
+		while (position != 0)
+		{
+			uint32_t parent = (position - 1) / ARITY;
+
+			if (this->keys[this->heap[parent]] <= this->keys[item])
+			{
+				break;
+			}
+
+			this->heap[position] = this->heap[parent];
+			this->positions[this->heap[position]] = position;
+			position = parent;
+		}
+
+		this->heap[position] = item;
+		this->positions[item] = position;
+	}
+
+	void _sift_down(uint32_t position)
+	{
+		uint32_t item = this->heap[position];
+		uint32_t size = this->heap.size();
+
+		while (true)
+		{
+			uint32_t first = position * ARITY + 1;
+			uint32_t best = first;
+
+			if (first >= size)
+			{
+				break;
+			}
+
+			for (uint32_t child = first + 1; child < MIN(first + ARITY, size); ++child)
+			{
+				if (this->keys[this->heap[child]] < this->keys[this->heap[best]])
+				{
+					best = child;
+				}
+			}
+
+			if (this->keys[this->heap[best]] >= this->keys[item])
+			{
+				break;
+			}
+
+			this->heap[position] = this->heap[best];
+			this->positions[this->heap[position]] = position;
+			position = best;
+		}
+
+		this->heap[position] = item;
+		this->positions[item] = position;
+	}
+
+	bool contains(uint32_t item)
+	{
+		return this->positions[item] != UINT32_MAX;
+	}
+
+	// Inserts the item or lowers its key
+	void push(KEY key, uint32_t item)
+	{
+		if (this->positions[item] == UINT32_MAX)
+		{
+			this->positions[item] = this->heap.size();
+			this->heap.push_back(item);
+		}
+
+		this->keys[item] = key;
+		this->_sift_up(this->positions[item]);
+	}
+
+	pair<KEY, uint32_t> pop()
+	{
+		uint32_t item = this->heap[0];
+		uint32_t last = this->heap.back();
+
+		this->heap.pop_back();
+		this->positions[item] = UINT32_MAX;
+
+		if (this->heap.size() != 0)
+		{
+			this->heap[0] = last;
+			this->positions[last] = 0;
+			this->_sift_down(0);
+		}
+
+		return {this->keys[item], item};
+	}
+
+	uint32_t size()
+	{
+		return this->heap.size();
+	}
+
+	void clear()
+	{
+		for (uint32_t item : this->heap)
+		{
+			this->positions[item] = UINT32_MAX;
+		}
+
+		this->heap.clear();
+	}
+};
@@ -22,6 +22,15 @@
 
 // Miscellaneous
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+
+// System
+#ifndef _WIN32
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
 
 using namespace std;
 
@@ -32,6 +41,9 @@ using namespace std;
 #define NEG(a)     (~(a) + 1)
 #define ABS(a)     ((a) < 0 ? -(a) : (a))
 
+// Interactive problems read input on demand through cin and flush after every OUT
+#define INTERACTIVE 0
+
 // concepts
 template <typename T>
 concept container = requires(T a) {
@@ -93,11 +105,415 @@ using min_priority_queue = priority_queue<T, vector<T>, greater<T>>;
 template <typename T>
 using max_priority_queue = priority_queue<T, vector<T>, less<T>>;
 
+// Fast input
+template <typename T>
+concept character = same_as<T, char> || same_as<T, signed char> || same_as<T, unsigned char>;
+
+struct fast_input
+{
+	vector<char> storage;
+	const char *buffer = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+
+	fast_input()
+	{
+#ifndef _WIN32
+		struct stat info;
+
+		// Map stdin directly if it is a file
+		if (fstat(0, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+		{
+			void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+
+			if (map != MAP_FAILED)
+			{
+				this->buffer = static_cast<const char *>(map);
+				this->size = info.st_size;
+
+				return;
+			}
+		}
+#endif
+
+		// Otherwise slurp everything into one buffer
+		size_t count = 0;
+		this->storage.resize(1 << 16);
+
+		while ((count = fread(this->storage.data() + this->size, 1, this->storage.size() - this->size, stdin)) != 0)
+		{
+			this->size += count;
+
+			if (this->size == this->storage.size())
+			{
+				this->storage.resize(this->size * 2);
+			}
+		}
+
+		this->buffer = this->storage.data();
+	}
+
+	void _skip()
+	{
+		while (this->pos < this->size && this->buffer[this->pos] <= ' ')
+		{
+			this->pos += 1;
+		}
+	}
+
+	template <character T>
+	void read(T &value)
+	{
+		this->_skip();
+
+		if (this->pos < this->size)
+		{
+			value = this->buffer[this->pos++];
+		}
+	}
+
+	void read(bool &value)
+	{
+		this->_skip();
+
+		if (this->pos < this->size)
+		{
+			value = this->buffer[this->pos++] != '0';
+		}
+	}
+
+	template <integral T>
+		requires(!character<T> && !same_as<T, bool>)
+	void read(T &value)
+	{
+		make_unsigned_t<T> result = 0;
+		uint8_t negative = 0;
+		uint8_t digit = 0;
+
+		this->_skip();
+
+		if constexpr (is_signed_v<T>)
+		{
+			if (this->pos < this->size && this->buffer[this->pos] == '-')
+			{
+				negative = 1;
+				this->pos += 1;
+			}
+		}
+
+		while (this->pos < this->size && (digit = this->buffer[this->pos] - '0') < 10)
+		{
+			result = (result * 10) + digit;
+			this->pos += 1;
+		}
+
+		value = negative ? NEG(result) : result;
+	}
+
+	template <floating_point T>
+	void read(T &value)
+	{
+		this->_skip();
+		this->pos = from_chars(this->buffer + this->pos, this->buffer + this->size, value).ptr - this->buffer;
+	}
+
+	void read(string &value)
+	{
+		size_t start = 0;
+
+		this->_skip();
+		start = this->pos;
+
+		while (this->pos < this->size && this->buffer[this->pos] > ' ')
+		{
+			this->pos += 1;
+		}
+
+		value.assign(this->buffer + start, this->pos - start);
+	}
+
+	template <typename T1, typename T2>
+	void read(pair<T1, T2> &p)
+	{
+		this->read(p.first);
+		this->read(p.second);
+	}
+
+	template <container T>
+	void read(T &container)
+	{
+		for (auto &x : container)
+		{
+			this->read(x);
+		}
+	}
+
+	// Anything else goes through its operator>> over the unread part of the buffer
+	struct _view : streambuf
+	{
+		_view(const char *begin, const char *end)
+		{
+			this->setg(const_cast<char *>(begin), const_cast<char *>(begin), const_cast<char *>(end));
+		}
+
+		const char *position() const
+		{
+			return this->gptr();
+		}
+	};
+
+	template <typename T>
+	void read(T &value)
+	{
+		_view view(this->buffer + this->pos, this->buffer + this->size);
+		istream stream(&view);
+
+		stream >> value;
+		this->pos = view.position() - this->buffer;
+	}
+};
+
+static fast_input &reader()
+{
+	static fast_input in;
+	return in;
+}
+
+// Fast output
+struct fast_output
+{
+	static constexpr size_t capacity = 1 << 16;
+
+	static constexpr auto digits = []
+	{
+		array<char, 200> table = {};
+
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			table[(i * 2) + 0] = '0' + (i / 10);
+			table[(i * 2) + 1] = '0' + (i % 10);
+		}
+
+		return table;
+	}();
+
+	char buffer[capacity];
+	size_t pos = 0;
+
+	// Matches the default cout formatting
+	int32_t precision = 6;
+
+	~fast_output()
+	{
+		this->flush();
+	}
+
+	void flush()
+	{
+		fwrite(this->buffer, 1, this->pos, stdout);
+		fflush(stdout);
+
+		this->pos = 0;
+	}
+
+	void _reserve(size_t count)
+	{
+		if (this->pos + count > capacity)
+		{
+			fwrite(this->buffer, 1, this->pos, stdout);
+			this->pos = 0;
+		}
+	}
+
+	template <character T>
+	void write(T value)
+	{
+		this->_reserve(1);
+		this->buffer[this->pos++] = value;
+	}
+
+	// A template, so string literals do not decay into it
+	template <same_as<bool> T>
+	void write(T value)
+	{
+		this->_reserve(1);
+		this->buffer[this->pos++] = value ? '1' : '0';
+	}
+
+	template <integral T>
+		requires(!character<T> && !same_as<T, bool>)
+	void write(T value)
+	{
+		make_unsigned_t<T> result = value;
+		char temp[24];
+		uint32_t start = 24;
+
+		this->_reserve(24);
+
+		if constexpr (is_signed_v<T>)
+		{
+			if (value < 0)
+			{
+				this->buffer[this->pos++] = '-';
+				result = NEG(result);
+			}
+		}
+
+		// Two digits at a time
+		while (result >= 100)
+		{
+			uint32_t index = (result % 100) * 2;
+			result /= 100;
+
+			temp[--start] = digits[index + 1];
+			temp[--start] = digits[index];
+		}
+
+		if (result >= 10)
+		{
+			temp[--start] = digits[(result * 2) + 1];
+			temp[--start] = digits[result * 2];
+		}
+		else
+		{
+			temp[--start] = '0' + result;
+		}
+
+		memcpy(this->buffer + this->pos, temp + start, 24 - start);
+		this->pos += 24 - start;
+	}
+
+	template <floating_point T>
+	void write(T value)
+	{
+		// Sign, leading digits, point, exponent and the requested precision
+		size_t limit = MIN(static_cast<size_t>(MAX(this->precision, 0)) + 32, capacity);
+		to_chars_result result;
+
+		this->_reserve(limit);
+		result = to_chars(this->buffer + this->pos, this->buffer + this->pos + limit, value, chars_format::general, this->precision);
+
+		if (result.ec != errc())
+		{
+			// Larger than a buffer, leave it to the standard formatting
+			this->flush();
+			printf("%.*Lg", static_cast<int>(this->precision), static_cast<long double>(value));
+
+			return;
+		}
+
+		this->pos = result.ptr - this->buffer;
+	}
+
+	void write(string_view value)
+	{
+		if (value.size() > capacity)
+		{
+			this->_reserve(capacity);
+			fwrite(value.data(), 1, value.size(), stdout);
+
+			return;
+		}
+
+		this->_reserve(value.size());
+		memcpy(this->buffer + this->pos, value.data(), value.size());
+		this->pos += value.size();
+	}
+
+	// Pair members print the way format("{}") does, bools as words and floats in their shortest form
+	template <typename T>
+	void _write_formatted(const T &value)
+	{
+		if constexpr (same_as<T, bool>)
+		{
+			this->write(string_view(value ? "true" : "false"));
+		}
+		else if constexpr (floating_point<T>)
+		{
+			char temp[64];
+			this->write(string_view(temp, to_chars(temp, temp + 64, value).ptr - temp));
+		}
+		else
+		{
+			this->write(value);
+		}
+	}
+
+	template <typename T1, typename T2>
+	void write(const pair<T1, T2> &p)
+	{
+		this->write('(');
+		this->_write_formatted(p.first);
+		this->write(' ');
+		this->_write_formatted(p.second);
+		this->write(')');
+	}
+
+	template <container T>
+	void write(const T &container)
+	{
+		for (const auto &x : container)
+		{
+			this->write(x);
+			this->write(' ');
+		}
+	}
+
+	// Anything else goes through its operator<< straight into the buffer
+	struct _sink : streambuf
+	{
+		fast_output &out;
+
+		_sink(fast_output &out) : out(out)
+		{
+		}
+
+		int_type overflow(int_type c) override
+		{
+			if (c != traits_type::eof())
+			{
+				this->out.write(static_cast<char>(c));
+			}
+
+			return c;
+		}
+
+		streamsize xsputn(const char *data, streamsize count) override
+		{
+			this->out.write(string_view(data, count));
+			return count;
+		}
+	};
+
+	template <typename T>
+		requires(!integral<T> && !floating_point<T> && !convertible_to<const T &, string_view> && !container<T>)
+	void write(const T &value)
+	{
+		_sink sink(*this);
+		ostream stream(&sink);
+
+		stream << value;
+	}
+};
+
+static fast_output &writer()
+{
+	static fast_output out;
+	return out;
+}
+
 // IO
 template <typename... T>
 static void input(T &...args)
 {
-	((cin >> args), ...);
+	if constexpr (INTERACTIVE)
+	{
+		((cin >> args), ...);
+	}
+	else
+	{
+		(reader().read(args), ...);
+	}
 }
 
 #define IN(...) input(__VA_ARGS__)
@@ -105,10 +521,17 @@ static void input(T &...args)
 template <typename... T>
 static void output(T &&...args)
 {
-	((cout << args << ' '), ...) << endl;
+	((writer().write(args), writer().write(' ')), ...);
+	writer().write('\n');
+
+	if constexpr (INTERACTIVE)
+	{
+		writer().flush();
+	}
 }
 
 #define OUT(...) output(__VA_ARGS__)
+#define FLUSH()  writer().flush()
 
 template <typename... T>
 static void debug(T &&...args)
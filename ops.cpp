@@ -1,29 +1,5 @@
 #include "cp.h"
-
-template <typename T>
-struct op_add
-{
-	T identity()
-	{
-		return 0;
-	}
-
-	T join(const T &a, const T &b) const
-	{
-		return a + b;
-	}
-
-	T inverse(const T &a, const T &b) const
-	{
-		return a - b;
-	}
-
-	template <typename U>
-	T assign(const U &element, [[maybe_unused]] uint32_t index) const
-	{
-		return static_cast<T>(element);
-	}
-};
+#include "sums.cpp"
 
 template <typename T>
 struct op_mul
@@ -541,6 +517,240 @@ struct range_add_set_minmax_op : range_max_op<T>, range_add_set_op<T>
 	}
 };
 
+template <typename T>
+struct range_beats_node
+{
+	T max1, max2; // largest and second largest value
+	T min1, min2; // smallest and second smallest value
+	uint32_t max_count, min_count;
+	uint32_t size; // second values exist only if their count is less than size
+	T sum;
+};
+
+template <typename T>
+struct range_beats_update
+{
+	// x -> MIN(MAX(x + add, low), high)
+	T add;
+	T low;
+	T high;
+};
+
+// Range chmin, chmax, add with range sum, max, min
+template <typename T>
+struct range_beats_op
+{
+	static constexpr T lowest = numeric_limits<T>::lowest();
+	static constexpr T highest = numeric_limits<T>::max();
+
+	// Updates
+	range_beats_update<T> chmin(T value)
+	{
+		return {0, lowest, value};
+	}
+
+	range_beats_update<T> chmax(T value)
+	{
+		return {0, value, highest};
+	}
+
+	range_beats_update<T> add(T value)
+	{
+		return {value, lowest, highest};
+	}
+
+	range_beats_node<T> identity()
+	{
+		return {lowest, lowest, highest, highest, 0, 0, 0, 0};
+	}
+
+	range_beats_node<T> join(const range_beats_node<T> &left, const range_beats_node<T> &right) const
+	{
+		range_beats_node<T> result;
+
+		if (left.size == 0)
+		{
+			return right;
+		}
+
+		if (right.size == 0)
+		{
+			return left;
+		}
+
+		result.size = left.size + right.size;
+		result.sum = left.sum + right.sum;
+
+		// max
+		if (left.max1 == right.max1)
+		{
+			result.max1 = left.max1;
+			result.max_count = left.max_count + right.max_count;
+			result.max2 = MAX(left.max_count < left.size ? left.max2 : lowest, right.max_count < right.size ? right.max2 : lowest);
+		}
+		else if (left.max1 > right.max1)
+		{
+			result.max1 = left.max1;
+			result.max_count = left.max_count;
+			result.max2 = MAX(left.max_count < left.size ? left.max2 : lowest, right.max1);
+		}
+		else
+		{
+			result.max1 = right.max1;
+			result.max_count = right.max_count;
+			result.max2 = MAX(right.max_count < right.size ? right.max2 : lowest, left.max1);
+		}
+
+		// min
+		if (left.min1 == right.min1)
+		{
+			result.min1 = left.min1;
+			result.min_count = left.min_count + right.min_count;
+			result.min2 = MIN(left.min_count < left.size ? left.min2 : highest, right.min_count < right.size ? right.min2 : highest);
+		}
+		else if (left.min1 < right.min1)
+		{
+			result.min1 = left.min1;
+			result.min_count = left.min_count;
+			result.min2 = MIN(left.min_count < left.size ? left.min2 : highest, right.min1);
+		}
+		else
+		{
+			result.min1 = right.min1;
+			result.min_count = right.min_count;
+			result.min2 = MIN(right.min_count < right.size ? right.min2 : highest, left.min1);
+		}
+
+		return result;
+	}
+
+	template <typename U>
+	range_beats_node<T> assign(const U &element, [[maybe_unused]] uint32_t index) const
+	{
+		T value = static_cast<T>(element);
+		return {value, lowest, value, highest, 1, 1, 1, value};
+	}
+
+	// Only called when the tag condition holds
+	range_beats_node<T> apply(const range_beats_node<T> &element, const range_beats_update<T> &update, [[maybe_unused]] uint32_t begin,
+							  [[maybe_unused]] uint32_t end)
+	{
+		range_beats_node<T> result = element;
+
+		if (result.size == 0)
+		{
+			return result;
+		}
+
+		if (update.add != 0)
+		{
+			result.sum += update.add * result.size;
+			result.max1 += update.add;
+			result.min1 += update.add;
+
+			if (result.max_count < result.size)
+			{
+				result.max2 += update.add;
+			}
+
+			if (result.min_count < result.size)
+			{
+				result.min2 += update.add;
+			}
+		}
+
+		// chmax only changes the smallest values
+		if (update.low > result.min1)
+		{
+			result.sum += (update.low - result.min1) * result.min_count;
+
+			if (result.min1 == result.max1)
+			{
+				result.max1 = update.low;
+			}
+			else if (result.max_count < result.size && result.max2 == result.min1)
+			{
+				result.max2 = update.low;
+			}
+
+			result.min1 = update.low;
+		}
+
+		// chmin only changes the largest values
+		if (update.high < result.max1)
+		{
+			result.sum -= (result.max1 - update.high) * result.max_count;
+
+			if (result.max1 == result.min1)
+			{
+				result.min1 = update.high;
+			}
+			else if (result.min_count < result.size && result.min2 == result.max1)
+			{
+				result.min2 = update.high;
+			}
+
+			result.max1 = update.high;
+		}
+
+		return result;
+	}
+
+	range_beats_update<T> compose(const range_beats_update<T> &current, const range_beats_update<T> &update)
+	{
+		range_beats_update<T> result;
+
+		T low = current.low == lowest ? lowest : current.low + update.add;
+		T high = current.high == highest ? highest : current.high + update.add;
+
+		result.add = current.add + update.add;
+		result.low = MAX(low, update.low);
+		result.high = MIN(MAX(high, update.low), update.high);
+
+		return result;
+	}
+
+	range_beats_update<T> reset()
+	{
+		return {0, lowest, highest};
+	}
+
+	// Break condition
+	bool skip(const range_beats_node<T> &element, const range_beats_update<T> &update)
+	{
+		if (element.size == 0)
+		{
+			return true;
+		}
+
+		return update.add == 0 && update.low <= element.min1 && update.high >= element.max1;
+	}
+
+	// Tag condition fails when values other than the extremes are affected
+	bool fail(const range_beats_node<T> &element, const range_beats_update<T> &update)
+	{
+		if (element.size == 0)
+		{
+			return false;
+		}
+
+		if (update.low > element.min1 + update.add && element.min_count < element.size && update.low >= element.min2 + update.add)
+		{
+			return true;
+		}
+
+		if (update.high < element.max1 + update.add && element.max_count < element.size && update.high <= element.max2 + update.add)
+		{
+			return true;
+		}
+
+		return false;
+	}
+};
+
+template <typename T>
+using range_beats = lazy_segment_tree<range_beats_node<T>, range_beats_update<T>, range_beats_op<T>>;
+
 // For simple segment trees
 struct node
 {
@@ -625,4 +835,19 @@ struct seg_op
 	{
 		return {};
 	}
+
+	// For segment tree beats
+#if 0
+	// Break condition, the update changes nothing in the node
+	bool skip(const node &element, const lazy &update)
+	{
+		return false;
+	}
+
+	// Tag condition fails, the update can not be applied to the whole node
+	bool fail(const node &element, const lazy &update)
+	{
+		return false;
+	}
+#endif
 };
@@ -1,4 +1,7 @@
 #include <concepts>
+#include <iterator>
+#include <memory>
+#include <stack>
 #include <vector>
 
 using namespace std;
@@ -18,32 +21,44 @@ struct rbtree
 	// node -> optional pointer to node responsible for current
 	// size -> number of nodes in the subtree including self
 	// color -> 0 for black, 1 for red
-	// parent -> parent of node
-	// left -> left child of node
-	// right -> right child of node
+	// parent -> index of parent of node
+	// left -> index of left child of node
+	// right -> index of right child of node
+	//
+	// Links are 32 bit indices into the node slab, 0 is null.
+
+	// Links of a node, persistent trees share subtrees and drop the parent
+	struct rblinks
+	{
+		uint32_t parent = 0, left = 0, right = 0;
+	};
+
+	struct rblinks_persistent
+	{
+		uint32_t left = 0, right = 0;
+	};
 
-	struct rbnode_set
+	template <typename LINKS>
+	struct rbnode_set : LINKS
 	{
 		key_type key = {};
 
 		uint32_t size : 31 = 0;
 		uint8_t color : 1 = 0;
-
-		rbnode_set *parent = nullptr, *left = nullptr, *right = nullptr;
 	};
 
-	struct rbnode_map
+	template <typename LINKS>
+	struct rbnode_map : LINKS
 	{
 		key_type key = {};
 		value_type value = {};
 
 		uint32_t size : 31 = 0;
 		uint8_t color : 1 = 0;
-
-		rbnode_map *parent = nullptr, *left = nullptr, *right = nullptr;
 	};
 
-	struct rbnode_set_ext
+	template <typename LINKS>
+	struct rbnode_set_ext : LINKS
 	{
 		key_type key = {};
 		priority_type priority = {};
@@ -52,11 +67,11 @@ struct rbtree
 		uint32_t size : 31 = 0;
 		uint8_t color : 1 = 0;
 
-		// rbnode_set_ext *node = nullptr;
-		rbnode_set_ext *parent = nullptr, *left = nullptr, *right = nullptr;
+		// uint32_t node = 0;
 	};
 
-	struct rbnode_map_ext
+	template <typename LINKS>
+	struct rbnode_map_ext : LINKS
 	{
 		key_type key = {};
 		value_type value = {};
@@ -66,33 +81,82 @@ struct rbtree
 		uint32_t size : 31 = 0;
 		uint8_t color : 1 = 0;
 
-		// rbnode_map_ext *node = nullptr;
-		rbnode_map_ext *parent = nullptr, *left = nullptr, *right = nullptr;
+		// uint32_t node = 0;
 	};
 
 	// Choose the correct node type based on templates
-	using rbnode =
-		conditional_t<is_same_v<VALUE, void> && is_same_v<PRIORITY, void>, rbnode_set,
-					  conditional_t<!is_same_v<VALUE, void> && is_same_v<PRIORITY, void>, rbnode_map,
-									conditional_t<is_same_v<VALUE, void> && !is_same_v<PRIORITY, void>, rbnode_set_ext, rbnode_map_ext>>>;
+	template <typename LINKS>
+	using rbnode_select =
+		conditional_t<is_same_v<VALUE, void> && is_same_v<PRIORITY, void>, rbnode_set<LINKS>,
+					  conditional_t<!is_same_v<VALUE, void> && is_same_v<PRIORITY, void>, rbnode_map<LINKS>,
+									conditional_t<is_same_v<VALUE, void> && !is_same_v<PRIORITY, void>, rbnode_set_ext<LINKS>, rbnode_map_ext<LINKS>>>>;
 
-	// Concepts for use
-	template <typename CONTAINER>
-	static constexpr bool clearable = requires(CONTAINER container) { container.clear(); };
+	using rbnode = rbnode_select<rblinks>;
 
+	// Concepts for use
 	template <typename CONTAINER, typename TYPE>
 	static constexpr bool insertable = requires(CONTAINER container, TYPE type) { container.insert(type); };
 
-	vector<rbnode *> _pool; // pool of all allocated nodes
-	vector<rbnode *> _free; // pool of nodes that can be resused
+	// Nodes live in chunks that double in size (16, 32, 64, ...) and are never moved,
+	// so pointers handed out to callers stay valid until the node is erased.
+	// Trees produced by split share the slab of their source so split and join only relink nodes.
+	static constexpr uint32_t _base = 4;
+
+	struct rbslab
+	{
+		vector<vector<rbnode>> chunks; // all allocated nodes
+		vector<uint32_t> free;         // nodes that can be resused
+		uint32_t next = 1;             // first never used index, 0 is reserved for null
+	};
+
+	shared_ptr<rbslab> _slab; // node storage, possibly shared with other trees
 
-	rbnode *_root;   // root of tree
+	uint32_t _root;  // root of tree
 	uint32_t _count; // number of nodes in tree
 
 	rbtree()
 	{
-		this->_root = nullptr;
+		this->_slab = make_shared<rbslab>();
+		this->_root = 0;
+		this->_count = 0;
+	}
+
+	template <typename ITERATOR>
+	rbtree(ITERATOR begin, ITERATOR end)
+	{
+		this->_slab = make_shared<rbslab>();
+		this->_root = 0;
 		this->_count = 0;
+
+		this->build(begin, end);
+	}
+
+	rbtree(const rbtree &other)
+	{
+		// Copies own a private slab, the indices stay valid in the copy
+		this->_slab = make_shared<rbslab>(*other._slab);
+		this->_root = other._root;
+		this->_count = other._count;
+	}
+
+	rbtree(rbtree &&other)
+	{
+		this->_slab = std::move(other._slab);
+		this->_root = other._root;
+		this->_count = other._count;
+
+		other._slab = make_shared<rbslab>();
+		other._root = 0;
+		other._count = 0;
+	}
+
+	rbtree &operator=(rbtree other)
+	{
+		swap(this->_slab, other._slab);
+		swap(this->_root, other._root);
+		swap(this->_count, other._count);
+
+		return *this;
 	}
 
 	~rbtree()
@@ -100,149 +164,219 @@ struct rbtree
 		this->_clear();
 	}
 
-	rbnode *_alloc_node()
+	rbnode &_node(uint32_t index)
+	{
+		uint32_t slot = index + (1u << _base);
+		uint32_t chunk = (31 - __builtin_clz(slot));
+
+		return this->_slab->chunks[chunk - _base][slot - (1u << chunk)];
+	}
+
+	rbnode *_ptr(uint32_t index)
+	{
+		if (index == 0)
+		{
+			return nullptr;
+		}
+
+		return &this->_node(index);
+	}
+
+	uint32_t _index(rbnode *node)
+	{
+		if (node == nullptr)
+		{
+			return 0;
+		}
+
+		if (node->parent == 0)
+		{
+			return this->_root;
+		}
+
+		rbnode &parent = this->_node(node->parent);
+
+		return (parent.left != 0 && &this->_node(parent.left) == node) ? parent.left : parent.right;
+	}
+
+	uint32_t _capacity()
+	{
+		return (1u << (_base + this->_slab->chunks.size())) - (1u << _base);
+	}
+
+	void _grow()
+	{
+		this->_slab->chunks.push_back(vector<rbnode>(size_t(1) << (_base + this->_slab->chunks.size())));
+	}
+
+	// Preallocate nodes for count keys
+	void reserve(uint32_t count)
+	{
+		while (this->_capacity() < count + 1)
+		{
+			this->_grow();
+		}
+	}
+
+	uint32_t _alloc_node()
 	{
-		rbnode *node = nullptr;
+		uint32_t index = 0;
 
 		this->_count += 1;
 
 		// Reuse any nodes first before allocating new ones
-		if (this->_free.size() != 0)
+		if (this->_slab->free.size() != 0)
 		{
-			node = this->_free.back();
-			this->_free.pop_back();
+			index = this->_slab->free.back();
+			this->_slab->free.pop_back();
 		}
 		else
 		{
-			node = new rbnode;
-			this->_pool.push_back(node);
+			index = this->_slab->next++;
+
+			while (index >= this->_capacity())
+			{
+				this->_grow();
+			}
 		}
 
+		rbnode &node = this->_node(index);
+
 		// Always create a red node
-		node->size = 1;
-		node->color = 1;
+		node.size = 1;
+		node.color = 1;
 
-		node->left = nullptr;
-		node->right = nullptr;
-		node->parent = nullptr;
+		node.left = 0;
+		node.right = 0;
+		node.parent = 0;
 
 		// Default constructor for complex types
 		if constexpr (!is_same_v<VALUE, void>)
 		{
-			node->value = {};
+			node.value = {};
 		}
 
 		if constexpr (!is_same_v<PRIORITY, void>)
 		{
-			node->priority = {};
-			node->current = {};
+			node.priority = {};
+			node.current = {};
 		}
 
-		return node;
+		return index;
 	}
 
-	void _free_node(rbnode *node)
+	void _free_node(uint32_t index)
 	{
-		if (node == nullptr)
+		if (index == 0)
 		{
 			return;
 		}
 
 		this->_count -= 1;
-		this->_free.push_back(node);
+		this->_slab->free.push_back(index);
 	}
 
 	void _clear()
 	{
-		while (this->_pool.size() != 0)
+		if (this->_slab.use_count() == 1)
+		{
+			// Release the slab
+			this->_slab->chunks.clear();
+			this->_slab->free.clear();
+			this->_slab->next = 1;
+		}
+		else
 		{
-			rbnode *node = this->_pool.back();
+			// Other trees still use the slab, only return our nodes
+			stack<uint32_t> st;
 
-			// Clear containers
-			if constexpr (clearable<KEY>)
+			if (this->_root != 0)
 			{
-				node->key.clear();
+				st.push(this->_root);
 			}
 
-			if constexpr (!is_same_v<VALUE, void> && clearable<VALUE>)
+			while (!st.empty())
 			{
-				node->value.clear();
-			}
+				uint32_t node = st.top();
+				st.pop();
 
-			if constexpr (!is_same_v<PRIORITY, void> && clearable<PRIORITY>)
-			{
-				node->priority.clear();
-			}
+				if (this->_node(node).left != 0)
+				{
+					st.push(this->_node(node).left);
+				}
 
-			this->_pool.pop_back();
-			delete node;
-		}
+				if (this->_node(node).right != 0)
+				{
+					st.push(this->_node(node).right);
+				}
 
-		// Clear the node pools
-		this->_pool.clear();
-		this->_free.clear();
+				this->_slab->free.push_back(node);
+			}
+		}
 
 		// Clear the root
-		this->_root = nullptr;
+		this->_root = 0;
 		this->_count = 0;
 	}
 
-	bool _color(rbnode *node)
+	bool _color(uint32_t index)
 	{
 		// Undefined nodes are always black
-		if (node == nullptr)
+		if (index == 0)
 		{
 			return 0;
 		}
 
-		return node->color;
+		return this->_node(index).color;
 	}
 
-	priority_type _priority(rbnode *node)
+	priority_type _priority(uint32_t index)
 		requires(!std::is_same_v<PRIORITY, void>)
 	{
 		// Assign priority based on value or key here
 		return 0;
 	}
 
-	void _size(rbnode *n)
+	void _size(uint32_t index)
 	{
 		uint32_t count = 1;
 
-		if (n == nullptr)
+		if (index == 0)
 		{
 			return;
 		}
 
-		count += n->left != nullptr ? n->left->size : 0;
-		count += n->right != nullptr ? n->right->size : 0;
+		rbnode &n = this->_node(index);
+
+		count += n.left != 0 ? this->_node(n.left).size : 0;
+		count += n.right != 0 ? this->_node(n.right).size : 0;
 
-		n->size = count;
+		n.size = count;
 	}
 
-	void _join(rbnode *node)
+	void _join(uint32_t index)
 	{
 		if constexpr (!is_same_v<PRIORITY, void>)
 		{
-			node->priority = this->_priority(node);
-			node->current = node->priority;
+			rbnode &node = this->_node(index);
 
-			if (node->left != nullptr)
+			node.priority = this->_priority(index);
+			node.current = node.priority;
+
+			if (node.left != 0)
 			{
-				node->current = MIN(node->current, node->left->current);
+				node.current = MIN(node.current, this->_node(node.left).current);
 			}
 
-			if (node->right != nullptr)
+			if (node.right != 0)
 			{
-				node->current = MIN(node->current, node->right->current);
+				node.current = MIN(node.current, this->_node(node.right).current);
 			}
 		}
 	}
 
-	void _left_rotate(rbnode *node)
+	void _left_rotate(uint32_t x)
 	{
-		rbnode *temp = nullptr;
-
 		// The right child of node will always exist.
 		//
 		//  node = X
@@ -255,47 +389,50 @@ struct rbtree
 		//     b   c              a   b
 		//
 
-		temp = node->right;
-		node->right = temp->left;
+		rbnode &node = this->_node(x);
+		uint32_t y = node.right;
+		rbnode &temp = this->_node(y);
 
-		if (temp->left != nullptr)
+		node.right = temp.left;
+
+		if (temp.left != 0)
 		{
-			temp->left->parent = node;
+			this->_node(temp.left).parent = x;
 		}
 
-		temp->parent = node->parent;
+		temp.parent = node.parent;
 
-		if (node->parent == nullptr)
+		if (node.parent == 0)
 		{
-			this->_root = temp;
+			this->_root = y;
 		}
 		else
 		{
-			if (node->parent->left == node)
+			rbnode &parent = this->_node(node.parent);
+
+			if (parent.left == x)
 			{
-				node->parent->left = temp;
+				parent.left = y;
 			}
 			else
 			{
-				node->parent->right = temp;
+				parent.right = y;
 			}
 		}
 
-		temp->left = node;
-		node->parent = temp;
+		temp.left = x;
+		node.parent = y;
 
 		// Update statisitics
-		this->_size(node);
-		this->_join(node);
+		this->_size(x);
+		this->_join(x);
 
-		this->_size(temp);
-		this->_join(temp);
+		this->_size(y);
+		this->_join(y);
 	}
 
-	void _right_rotate(rbnode *node)
+	void _right_rotate(uint32_t x)
 	{
-		rbnode *temp = nullptr;
-
 		// The left child of node will always exist.
 		//
 		//  node = X
@@ -308,89 +445,96 @@ struct rbtree
 		//   b   c                      c   a
 		//
 
-		temp = node->left;
-		node->left = temp->right;
+		rbnode &node = this->_node(x);
+		uint32_t y = node.left;
+		rbnode &temp = this->_node(y);
 
-		if (temp->right != nullptr)
+		node.left = temp.right;
+
+		if (temp.right != 0)
 		{
-			temp->right->parent = node;
+			this->_node(temp.right).parent = x;
 		}
 
-		temp->parent = node->parent;
+		temp.parent = node.parent;
 
-		if (node->parent == nullptr)
+		if (node.parent == 0)
 		{
-			this->_root = temp;
+			this->_root = y;
 		}
 		else
 		{
-			if (node->parent->left == node)
+			rbnode &parent = this->_node(node.parent);
+
+			if (parent.left == x)
 			{
-				node->parent->left = temp;
+				parent.left = y;
 			}
 			else
 			{
-				node->parent->right = temp;
+				parent.right = y;
 			}
 		}
 
-		temp->right = node;
-		node->parent = temp;
+		temp.right = x;
+		node.parent = y;
 
 		// Update statisitics
-		this->_size(node);
-		this->_join(node);
+		this->_size(x);
+		this->_join(x);
 
-		this->_size(temp);
-		this->_join(temp);
+		this->_size(y);
+		this->_join(y);
 	}
 
-	void _transplant(rbnode *u, rbnode *v)
+	void _transplant(uint32_t u, uint32_t v)
 	{
 		// Move v to u's position and only update the parent of u
 		// Status of u's children and v's children are handled by the caller
 		// NOTE: u should always exist
 		// NOTE: v can be null
 
-		if (u->parent == nullptr)
+		uint32_t parent = this->_node(u).parent;
+
+		if (parent == 0)
 		{
 			this->_root = v;
 		}
 		else
 		{
-			if (u == u->parent->left)
+			if (u == this->_node(parent).left)
 			{
-				u->parent->left = v;
+				this->_node(parent).left = v;
 			}
 			else
 			{
-				u->parent->right = v;
+				this->_node(parent).right = v;
 			}
 		}
 
-		if (v != nullptr)
+		if (v != 0)
 		{
-			v->parent = u->parent;
+			this->_node(v).parent = parent;
 		}
 	}
 
-	pair<rbnode *, uint8_t> _insert_find(key_type key)
+	pair<uint32_t, uint8_t> _insert_find(key_type key)
 	{
 		// Find a suitable position for the node and update its parent
-		rbnode *node = this->_root;
-		rbnode *temp = nullptr;
+		uint32_t node = this->_root;
+		uint32_t temp = 0;
 
-		while (node != nullptr)
+		while (node != 0)
 		{
 			temp = node;
 
-			if (key < node->key)
+			if (key < this->_node(node).key)
 			{
-				node = node->left;
+				node = this->_node(node).left;
 			}
 			else
 			{
-				if (key == node->key)
+				if (key == this->_node(node).key)
 				{
 					if constexpr (DUPLICATES == false)
 					{
@@ -398,76 +542,77 @@ struct rbtree
 					}
 				}
 
-				node = node->right;
+				node = this->_node(node).right;
 			}
 		}
 
 		node = this->_alloc_node();
 
-		node->key = key;
-		node->parent = temp;
+		this->_node(node).key = key;
+		this->_node(node).parent = temp;
 
-		if (temp == nullptr)
+		if (temp == 0)
 		{
 			this->_root = node;
-			this->_root->color = 0;
+			this->_node(node).color = 0;
 
 			return {node, 0};
 		}
 
-		if (node->key < temp->key)
+		if (this->_node(node).key < this->_node(temp).key)
 		{
-			temp->left = node;
+			this->_node(temp).left = node;
 		}
 		else
 		{
-			temp->right = node;
+			this->_node(temp).right = node;
 		}
 
 		return {node, 1};
 	}
 
-	void _insert_fixup(rbnode *node)
+	// Returns 1 if the root was turned red, which grows the black height of the tree by one
+	uint8_t _insert_fixup(uint32_t node)
 	{
 		// Fix any violations that can have occurred during insertion
 		// Only property that will be violated is a red node having a red parent
-		while (this->_color(node->parent))
+		while (this->_color(this->_node(node).parent))
 		{
 			// NOTE: grandparent will always exist here as parent will not be the root node
-			rbnode *parent = node->parent;
-			rbnode *grandparent = parent->parent;
-			rbnode *uncle = nullptr;
+			uint32_t parent = this->_node(node).parent;
+			uint32_t grandparent = this->_node(parent).parent;
+			uint32_t uncle = 0;
 
 			// Check the color parent's sibling, since the tree was valid before insertion
 			// the grandparent will be black and the sibling will always exist.
 			// If both parent and its sibling are red, change them to black,
 			// set grandparent to red repeat with grandparent's ancestors
 			// If the colors differ do a series of rotations (atmost 2) to fix the black height and terminate
-			if (parent == grandparent->left)
+			if (parent == this->_node(grandparent).left)
 			{
-				uncle = grandparent->right;
+				uncle = this->_node(grandparent).right;
 
 				if (this->_color(uncle))
 				{
-					parent->color = 0;
-					uncle->color = 0;
-					grandparent->color = 1;
+					this->_node(parent).color = 0;
+					this->_node(uncle).color = 0;
+					this->_node(grandparent).color = 1;
 
 					node = grandparent;
 				}
 				else
 				{
-					if (node == parent->right)
+					if (node == this->_node(parent).right)
 					{
 						node = parent;
 						this->_left_rotate(node);
 					}
 
-					parent = node->parent;
-					grandparent = parent->parent;
+					parent = this->_node(node).parent;
+					grandparent = this->_node(parent).parent;
 
-					parent->color = 0;
-					grandparent->color = 1;
+					this->_node(parent).color = 0;
+					this->_node(grandparent).color = 1;
 
 					this->_right_rotate(grandparent);
 
@@ -476,29 +621,29 @@ struct rbtree
 			}
 			else
 			{
-				uncle = grandparent->left;
+				uncle = this->_node(grandparent).left;
 
 				if (this->_color(uncle))
 				{
-					parent->color = 0;
-					uncle->color = 0;
-					grandparent->color = 1;
+					this->_node(parent).color = 0;
+					this->_node(uncle).color = 0;
+					this->_node(grandparent).color = 1;
 
 					node = grandparent;
 				}
 				else
 				{
-					if (node == parent->left)
+					if (node == this->_node(parent).left)
 					{
 						node = parent;
 						this->_right_rotate(node);
 					}
 
-					parent = node->parent;
-					grandparent = parent->parent;
+					parent = this->_node(node).parent;
+					grandparent = this->_node(parent).parent;
 
-					parent->color = 0;
-					grandparent->color = 1;
+					this->_node(parent).color = 0;
+					this->_node(grandparent).color = 1;
 
 					this->_left_rotate(grandparent);
 
@@ -507,30 +652,37 @@ struct rbtree
 			}
 		}
 
-		this->_root->color = 0;
-	}
+		uint8_t grown = this->_node(this->_root).color;
 
-	rbnode *insert(key_type key)
-	{
-		auto [node, fixup] = this->_insert_find(key);
-		rbnode *parent = node->parent;
+		this->_node(this->_root).color = 0;
 
-		this->_join(node);
+		return grown;
+	}
 
-		while (parent != nullptr)
+	void _update_path(uint32_t parent)
+	{
+		while (parent != 0)
 		{
 			this->_size(parent);
 			this->_join(parent);
 
-			parent = parent->parent;
+			parent = this->_node(parent).parent;
 		}
+	}
+
+	rbnode *insert(key_type key)
+	{
+		auto [node, fixup] = this->_insert_find(key);
+
+		this->_join(node);
+		this->_update_path(this->_node(node).parent);
 
 		if (fixup)
 		{
 			this->_insert_fixup(node);
 		}
 
-		return node;
+		return this->_ptr(node);
 	}
 
 	template <typename TYPE>
@@ -538,25 +690,17 @@ struct rbtree
 		requires(!std::is_same_v<VALUE, void>)
 	{
 		auto [node, fixup] = this->_insert_find(key);
-		rbnode *parent = node->parent;
 
-		node->value = value;
+		this->_node(node).value = value;
 		this->_join(node);
-
-		while (parent != nullptr)
-		{
-			this->_size(parent);
-			this->_join(parent);
-
-			parent = parent->parent;
-		}
+		this->_update_path(this->_node(node).parent);
 
 		if (fixup)
 		{
 			this->_insert_fixup(node);
 		}
 
-		return node;
+		return this->_ptr(node);
 	}
 
 	template <typename TYPE>
@@ -564,25 +708,17 @@ struct rbtree
 		requires(!std::is_same_v<VALUE, void> && insertable<VALUE, TYPE>)
 	{
 		auto [node, fixup] = this->_insert_find(key);
-		rbnode *parent = node->parent;
 
-		node->value.insert(value);
+		this->_node(node).value.insert(value);
 		this->_join(node);
-
-		while (parent != nullptr)
-		{
-			this->_size(parent);
-			this->_join(parent);
-
-			parent = parent->parent;
-		}
+		this->_update_path(this->_node(node).parent);
 
 		if (fixup)
 		{
 			this->_insert_fixup(node);
 		}
 
-		return node;
+		return this->_ptr(node);
 	}
 
 	template <typename TYPE>
@@ -590,7 +726,6 @@ struct rbtree
 		requires(!std::is_same_v<VALUE, void> && insertable<VALUE, TYPE>)
 	{
 		rbnode *node = this->find(key);
-		rbnode *parent = nullptr;
 
 		if (node == nullptr)
 		{
@@ -605,55 +740,48 @@ struct rbtree
 			return nullptr;
 		}
 
-		this->_join(node);
-		parent = node->parent;
-
-		while (parent != nullptr)
-		{
-			this->_size(parent);
-			this->_join(parent);
-
-			parent = parent->parent;
-		}
+		this->_join(this->_index(node));
+		this->_update_path(node->parent);
 
 		return node;
 	}
 
-	void erase(rbnode *node)
+	// When release is false the node is only unlinked and kept for the caller
+	void _erase(uint32_t node, bool release = true)
 	{
-		rbnode *successor = nullptr;
-		rbnode *parent = nullptr;
-		rbnode *temp = nullptr;
+		uint32_t successor = 0;
+		uint32_t parent = 0;
+		uint32_t temp = 0;
 		uint8_t color = 0;
 
-		if (node == nullptr)
+		if (node == 0)
 		{
 			return;
 		}
 
-		color = node->color;
+		color = this->_node(node).color;
 
-		if (node->left != nullptr && node->right != nullptr)
+		if (this->_node(node).left != 0 && this->_node(node).right != 0)
 		{
 			// If node contains both children, its successor will be leftmost child of its right child
 			// The successor will not have a left child but may have a right child.
 			// Transplant the successor to the node, taking on its color and set the new successor as the right child.
 			// NOTE: The new successor might be null, we only care about its parent
-			rbnode *min = node->right;
+			uint32_t min = this->_node(node).right;
 
-			while (min->left != nullptr)
+			while (this->_node(min).left != 0)
 			{
-				min = min->left;
+				min = this->_node(min).left;
 			}
 
-			color = min->color;
-			parent = min->parent;
-			successor = min->right;
+			color = this->_node(min).color;
+			parent = this->_node(min).parent;
+			successor = this->_node(min).right;
 
-			if (min != node->right)
+			if (min != this->_node(node).right)
 			{
-				this->_transplant(min, min->right);
-				temp = min->parent;
+				this->_transplant(min, this->_node(min).right);
+				temp = this->_node(min).parent;
 
 				// Update statistics from successor to node
 				while (parent != node)
@@ -661,11 +789,11 @@ struct rbtree
 					this->_size(parent);
 					this->_join(parent);
 
-					parent = parent->parent;
+					parent = this->_node(parent).parent;
 				}
 
-				min->right = node->right;
-				node->right->parent = min;
+				this->_node(min).right = this->_node(node).right;
+				this->_node(this->_node(node).right).parent = min;
 			}
 			else
 			{
@@ -674,42 +802,36 @@ struct rbtree
 
 			this->_transplant(node, min);
 
-			min->left = node->left;
-			min->left->parent = min;
-			min->color = node->color;
+			this->_node(min).left = this->_node(node).left;
+			this->_node(this->_node(min).left).parent = min;
+			this->_node(min).color = this->_node(node).color;
 
 			this->_size(min);
 			this->_join(min);
 		}
 		else
 		{
-			temp = node->parent; // In case if both children are null
+			temp = this->_node(node).parent; // In case if both children are null
 
-			if (node->left == nullptr)
+			if (this->_node(node).left == 0)
 			{
-				successor = node->right;
+				successor = this->_node(node).right;
 				this->_transplant(node, successor);
 			}
 			else
 			{
-				successor = node->left;
+				successor = this->_node(node).left;
 				this->_transplant(node, successor);
 			}
 		}
 
 		// Update statistics to root
-		parent = node->parent;
-
-		while (parent != nullptr)
+		this->_update_path(this->_node(node).parent);
+		if (release)
 		{
-			this->_size(parent);
-			this->_join(parent);
-
-			parent = parent->parent;
+			this->_free_node(node);
 		}
 
-		this->_free_node(node);
-
 		if (color)
 		{
 			return;
@@ -720,36 +842,36 @@ struct rbtree
 		// Fix any violations in black height that could have occured
 		while (successor != this->_root && this->_color(successor) == 0)
 		{
-			rbnode *sibling = nullptr;
+			uint32_t sibling = 0;
 
 			// It is guaranteed that the parent of the successor will not be null during any of the iterations.
 			// Update the parent on subsequent iteration after we update the successor to a valid node
-			if (successor != nullptr)
+			if (successor != 0)
 			{
-				parent = successor->parent;
+				parent = this->_node(successor).parent;
 			}
 
-			if (successor == parent->left)
+			if (successor == this->_node(parent).left)
 			{
 				// NOTE: The sibling can be null here. In that case its children are all black and we repeat
 				// the loop with parent's ancestors
-				sibling = parent->right;
+				sibling = this->_node(parent).right;
 
 				if (this->_color(sibling))
 				{
 					// This guarantees sibling exists, so the rotation is valid
-					sibling->color = 0;
-					parent->color = 1;
+					this->_node(sibling).color = 0;
+					this->_node(parent).color = 1;
 
 					this->_left_rotate(parent);
-					sibling = parent->right;
+					sibling = this->_node(parent).right;
 				}
 
-				if (sibling == nullptr || (this->_color(sibling->left) == 0 && this->_color(sibling->right) == 0))
+				if (sibling == 0 || (this->_color(this->_node(sibling).left) == 0 && this->_color(this->_node(sibling).right) == 0))
 				{
-					if (sibling != nullptr)
+					if (sibling != 0)
 					{
-						sibling->color = 1;
+						this->_node(sibling).color = 1;
 					}
 
 					successor = parent;
@@ -758,18 +880,18 @@ struct rbtree
 				{
 					// The sibling exists and has atleast one child which is red,
 					// perform rotations and terminate.
-					if (this->_color(sibling->right) == 0)
+					if (this->_color(this->_node(sibling).right) == 0)
 					{
-						sibling->left->color = 0;
-						sibling->color = 1;
+						this->_node(this->_node(sibling).left).color = 0;
+						this->_node(sibling).color = 1;
 
 						this->_right_rotate(sibling);
-						sibling = parent->right;
+						sibling = this->_node(parent).right;
 					}
 
-					sibling->color = parent->color;
-					parent->color = 0;
-					sibling->right->color = 0;
+					this->_node(sibling).color = this->_node(parent).color;
+					this->_node(parent).color = 0;
+					this->_node(this->_node(sibling).right).color = 0;
 
 					this->_left_rotate(parent);
 					successor = this->_root;
@@ -778,40 +900,40 @@ struct rbtree
 			}
 			else
 			{
-				sibling = parent->left;
+				sibling = this->_node(parent).left;
 
 				if (this->_color(sibling))
 				{
-					sibling->color = 0;
-					parent->color = 1;
+					this->_node(sibling).color = 0;
+					this->_node(parent).color = 1;
 
 					this->_right_rotate(parent);
-					sibling = parent->left;
+					sibling = this->_node(parent).left;
 				}
 
-				if (sibling == nullptr || (this->_color(sibling->left) == 0 && this->_color(sibling->right) == 0))
+				if (sibling == 0 || (this->_color(this->_node(sibling).left) == 0 && this->_color(this->_node(sibling).right) == 0))
 				{
-					if (sibling != nullptr)
+					if (sibling != 0)
 					{
-						sibling->color = 1;
+						this->_node(sibling).color = 1;
 					}
 
 					successor = parent;
 				}
 				else
 				{
-					if (this->_color(sibling->left) == 0)
+					if (this->_color(this->_node(sibling).left) == 0)
 					{
-						sibling->right->color = 0;
-						sibling->color = 1;
+						this->_node(this->_node(sibling).right).color = 0;
+						this->_node(sibling).color = 1;
 
 						this->_left_rotate(sibling);
-						sibling = parent->left;
+						sibling = this->_node(parent).left;
 					}
 
-					sibling->color = parent->color;
-					parent->color = 0;
-					sibling->left->color = 0;
+					this->_node(sibling).color = this->_node(parent).color;
+					this->_node(parent).color = 0;
+					this->_node(this->_node(sibling).left).color = 0;
 
 					this->_right_rotate(parent);
 					successor = this->_root;
@@ -823,12 +945,17 @@ struct rbtree
 		// NOTE: This step is important.
 		// When the loop terminates, set the current successor to black to maintain
 		// red-black properties
-		if (successor != nullptr)
+		if (successor != 0)
 		{
-			successor->color = 0;
+			this->_node(successor).color = 0;
 		}
 	}
 
+	void erase(rbnode *node)
+	{
+		this->_erase(this->_index(node));
+	}
+
 	void erase(key_type key)
 	{
 		return this->erase(this->find(key));
@@ -839,453 +966,1815 @@ struct rbtree
 		this->_clear();
 	}
 
-	void update(rbnode *node)
-		requires(!std::is_same_v<PRIORITY, void>)
+	// Replace the contents with a sorted range of keys (or key, value pairs for maps) in O(n).
+	// Without duplicates only the first of equal keys is kept.
+	template <typename ITERATOR>
+	void build(ITERATOR begin, ITERATOR end)
 	{
-		if (node == nullptr)
-		{
-			return;
-		}
+		stack<array<uint32_t, 4>> st;
+		vector<uint32_t> nodes;
+		vector<uint32_t> order;
 
-		node->priority = this->_priority(node);
-		node->current = node->priority;
+		this->_clear();
+		this->reserve(distance(begin, end));
 
-		while (node != nullptr)
+		for (auto it = begin; it != end; it++)
 		{
-			this->_join(node);
-			node = node->parent;
-		}
-	}
-
-	uint32_t query(key_type constraint)
-		requires(!std::is_same_v<PRIORITY, void>)
-	{
-		// Perform a tree walk
-		rbnode *node = this->_root;
-		rbnode *final = nullptr;
-		uint32_t result = UINT32_MAX;
+			key_type key;
 
-		// Copy the find_* template
-		// Example gte
-#if 0
-		while (node != nullptr)
-		{
-			if (constraint <= node->key)
+			if constexpr (is_same_v<VALUE, void>)
+			{
+				key = *it;
+			}
+			else
 			{
-				result = MIN(result, node->priority);
+				key = (*it).first;
+			}
 
-				if (node->right != nullptr)
+			if constexpr (DUPLICATES == false)
+			{
+				if (nodes.size() != 0 && !(this->_node(nodes.back()).key < key))
 				{
-					result = MIN(result, node->right->current);
+					continue;
 				}
-
-				final = node;
-				node = node->left;
 			}
-			else
+
+			uint32_t node = this->_alloc_node();
+
+			this->_node(node).key = key;
+
+			if constexpr (!is_same_v<VALUE, void>)
 			{
-				node = node->right;
+				this->_node(node).value = (*it).second;
 			}
+
+			nodes.push_back(node);
 		}
 
-		if (final != nullptr)
+		if (nodes.size() == 0)
 		{
-			if (final->right != nullptr)
-			{
-				result = MIN(result, final->right->current);
-			}
+			return;
 		}
-#endif
 
-		// Example lte
-#if 0
-		while (node != nullptr)
+		// Split every range at its middle, so all leaves are on the deepest two levels.
+		// Nodes on the deepest level are red unless the tree is perfect, everything else is black.
+		uint32_t count = nodes.size();
+		uint32_t deepest = 31 - __builtin_clz(count);
+		uint8_t perfect = ((count + 1) & count) == 0;
+
+		// begin, end, position of parent + 1, depth
+		st.push({0, count, 0, 0});
+
+		while (!st.empty())
 		{
-			if (constraint < node->key)
+			auto [left, right, parent, depth] = st.top();
+			st.pop();
+
+			if (left >= right)
 			{
+				continue;
+			}
 
-				node = node->left;
+			uint32_t middle = left + (right - left) / 2;
+			uint32_t node = nodes[middle];
+
+			this->_node(node).size = right - left;
+			this->_node(node).color = !perfect && depth == deepest;
+
+			if (parent == 0)
+			{
+				this->_root = node;
 			}
 			else
 			{
-				result = MIN(result, node->priority);
+				this->_node(node).parent = nodes[parent - 1];
 
-				if (node->left != nullptr)
+				if (middle < parent - 1)
 				{
-					result = MIN(result, node->left->current);
+					this->_node(nodes[parent - 1]).left = node;
+				}
+				else
+				{
+					this->_node(nodes[parent - 1]).right = node;
 				}
-
-				final = node;
-				node = node->right;
 			}
-		}
 
-		if (final != nullptr)
-		{
-			if (final->left != nullptr)
+			if constexpr (!is_same_v<PRIORITY, void>)
 			{
-				result = MIN(result, final->left->current);
+				order.push_back(node);
 			}
+
+			st.push({left, middle, middle + 1, depth + 1});
+			st.push({middle + 1, right, middle + 1, depth + 1});
 		}
-#endif
 
-		return result;
+		// Parents are visited before their children, so join in reverse
+		for (uint32_t i = order.size(); i != 0; --i)
+		{
+			this->_join(order[i - 1]);
+		}
 	}
 
-	rbnode *find(key_type key)
+	// Number of black nodes on any path from index down to a leaf
+	uint32_t _black_height(uint32_t index)
 	{
-		rbnode *node = this->_root;
+		uint32_t height = 0;
 
-		while (node != nullptr)
+		while (index != 0)
 		{
-			if (key == node->key)
-			{
-				return node;
-			}
-
-			if (key < node->key)
-			{
-				node = node->left;
-			}
-			else
-			{
-				node = node->right;
-			}
+			height += this->_color(index) == 0;
+			index = this->_node(index).left;
 		}
 
-		return nullptr;
+		return height;
 	}
 
-	// Get the node based on its rank
-	rbnode *get(uint32_t order)
+	// Join two detached trees with black roots and the given black heights around middle.
+	// All keys of left must be before middle and all keys of right after it.
+	// Returns the new root and its black height, the root is always black.
+	pair<uint32_t, uint32_t> _join3(uint32_t left, uint32_t lheight, uint32_t middle, uint32_t right, uint32_t rheight)
 	{
-		rbnode *node = this->_root;
+		rbnode &node = this->_node(middle);
 
-		if (order >= this->_count)
-		{
-			return nullptr;
-		}
+		node.parent = 0;
 
-		while (node != nullptr)
+		if (lheight == rheight)
 		{
-			uint32_t count = 1;
+			node.left = left;
+			node.right = right;
+			node.color = 0;
 
-			if (node->left != nullptr)
+			if (left != 0)
 			{
-				count += node->left->size;
+				this->_node(left).parent = middle;
 			}
 
-			if (count == (order + 1))
+			if (right != 0)
 			{
-				return node;
+				this->_node(right).parent = middle;
 			}
 
-			if (count > (order + 1))
-			{
-				node = node->left;
-			}
-			else
-			{
-				node = node->right;
-				order -= count;
-			}
+			this->_size(middle);
+			this->_join(middle);
+
+			return {middle, lheight + 1};
 		}
 
-		return nullptr;
-	}
+		// Walk down the spine of the taller tree until the black height matches,
+		// hang middle there as a red node and fix it up like an insertion
+		uint32_t current = lheight > rheight ? left : right;
+		uint32_t parent = 0;
+		uint32_t height = max(lheight, rheight);
 
-	// Get the rank of node (0 based)
-	uint32_t order(rbnode *node)
-	{
-		uint32_t count = 0;
+		while (this->_color(current) != 0 || height != min(lheight, rheight))
+		{
+			height -= this->_color(current) == 0;
+			parent = current;
+			current = lheight > rheight ? this->_node(current).right : this->_node(current).left;
+		}
 
-		if (node == nullptr)
+		node.color = 1;
+		node.parent = parent;
+
+		if (lheight > rheight)
 		{
-			return UINT32_MAX;
+			node.left = current;
+			node.right = right;
+			this->_node(parent).right = middle;
+			this->_root = left;
+		}
+		else
+		{
+			node.left = left;
+			node.right = current;
+			this->_node(parent).left = middle;
+			this->_root = right;
 		}
 
-		if (node->left != nullptr)
+		if (node.left != 0)
 		{
-			count += node->left->size;
+			this->_node(node.left).parent = middle;
 		}
 
-		while (node != nullptr)
+		if (node.right != 0)
 		{
-			if (node->parent != nullptr)
-			{
-				if (node->parent->right == node)
-				{
-					count += 1;
+			this->_node(node.right).parent = middle;
+		}
 
-					if (node->parent->left != nullptr)
-					{
-						count += node->parent->left->size;
-					}
-				}
-			}
+		this->_size(middle);
+		this->_join(middle);
+		this->_update_path(parent);
 
-			node = node->parent;
-		}
+		uint32_t grown = this->_insert_fixup(middle);
 
-		return count;
+		return {this->_root, max(lheight, rheight) + grown};
 	}
 
-	uint8_t contains(key_type key)
+	// Move the nodes for which right(node) holds into a new tree.
+	// right is asked once per node on a root to leaf path and decides which way to descend.
+	template <typename FUNCTION>
+	rbtree _split(FUNCTION &&right)
 	{
-		return this->find(key) != nullptr;
-	}
+		stack<array<uint32_t, 3>> st;
+		rbtree result;
 
-	uint32_t size()
-	{
-		return this->_count;
-	}
+		uint32_t node = this->_root;
+		uint32_t height = this->_black_height(node);
+
+		while (node != 0)
+		{
+			uint32_t side = right(node);
+
+			st.push({node, height, side});
+
+			height -= this->_color(node) == 0;
+			node = side ? this->_node(node).left : this->_node(node).right;
+		}
+
+		uint32_t left = 0, lheight = 0;
+		uint32_t rest = 0, rheight = 0;
+
+		// Rebuild both halves bottom up, each join only costs the difference in heights
+		while (!st.empty())
+		{
+			auto [node, height, side] = st.top();
+			st.pop();
+
+			uint32_t child = side ? this->_node(node).right : this->_node(node).left;
+			uint32_t cheight = height - (this->_color(node) == 0);
+
+			if (child != 0)
+			{
+				this->_node(child).parent = 0;
+
+				if (this->_color(child))
+				{
+					this->_node(child).color = 0;
+					cheight += 1;
+				}
+			}
+
+			if (side)
+			{
+				tie(rest, rheight) = this->_join3(rest, rheight, node, child, cheight);
+			}
+			else
+			{
+				tie(left, lheight) = this->_join3(child, cheight, node, left, lheight);
+			}
+		}
+
+		result._slab = this->_slab;
+		result._root = rest;
+		result._count = rest != 0 ? this->_node(rest).size : 0;
+
+		this->_root = left;
+		this->_count = left != 0 ? this->_node(left).size : 0;
+
+		return result;
+	}
+
+	// Keep keys lesser than key and return a tree with the remaining keys
+	rbtree split(key_type key)
+	{
+		return this->_split([&](uint32_t node) { return key <= this->_node(node).key; });
+	}
+
+	// Keep the first order keys and return a tree with the remaining keys
+	rbtree split_by_order(uint32_t order)
+	{
+		return this->_split(
+			[&](uint32_t node)
+			{
+				uint32_t count = 1;
+
+				if (this->_node(node).left != 0)
+				{
+					count += this->_node(this->_node(node).left).size;
+				}
+
+				if (order < count)
+				{
+					return true;
+				}
+
+				order -= count;
+				return false;
+			});
+	}
+
+	// Copy the nodes of other into our slab keeping its shape, returns the new root
+	uint32_t _copy(rbtree &other)
+	{
+		stack<array<uint32_t, 2>> st;
+		uint32_t root = 0;
+
+		if (other._root == 0)
+		{
+			return 0;
+		}
+
+		root = this->_alloc_node();
+		st.push({other._root, root});
+
+		while (!st.empty())
+		{
+			auto [source, destination] = st.top();
+			st.pop();
+
+			rbnode &from = other._node(source);
+			uint32_t parent = this->_node(destination).parent;
+
+			this->_node(destination) = from;
+			this->_node(destination).parent = parent;
+			this->_node(destination).left = 0;
+			this->_node(destination).right = 0;
+
+			if (from.left != 0)
+			{
+				uint32_t child = this->_alloc_node();
+
+				this->_node(child).parent = destination;
+				this->_node(destination).left = child;
+				st.push({from.left, child});
+			}
+
+			if (from.right != 0)
+			{
+				uint32_t child = this->_alloc_node();
+
+				this->_node(child).parent = destination;
+				this->_node(destination).right = child;
+				st.push({from.right, child});
+			}
+		}
+
+		return root;
+	}
+
+	// Append all keys of other, which must not be lesser than any key here, and leave other empty.
+	// Trees sharing a slab (from split) are joined in O(log n), others are copied over first.
+	void join(rbtree &other)
+	{
+		uint32_t left = this->_root;
+		uint32_t right = 0;
+		uint32_t middle = 0;
+
+		if (&other == this || other._root == 0)
+		{
+			return;
+		}
+
+		if (other._slab == this->_slab)
+		{
+			right = other._root;
+
+			other._root = 0;
+			other._count = 0;
+		}
+		else
+		{
+			right = this->_copy(other);
+			other.clear();
+		}
+
+		if (left == 0)
+		{
+			this->_root = right;
+			this->_count = this->_node(right).size;
+
+			return;
+		}
+
+		// Unlink the smallest key of right and use it to join both trees
+		middle = right;
+
+		while (this->_node(middle).left != 0)
+		{
+			middle = this->_node(middle).left;
+		}
+
+		this->_root = right;
+		this->_erase(middle, false);
+		right = this->_root;
+
+		uint32_t lheight = this->_black_height(left);
+		uint32_t rheight = this->_black_height(right);
+
+		this->_root = this->_join3(left, lheight, middle, right, rheight).first;
+		this->_count = this->_node(this->_root).size;
+	}
+
+	void update(rbnode *node)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		uint32_t index = this->_index(node);
+
+		if (index == 0)
+		{
+			return;
+		}
+
+		node->priority = this->_priority(index);
+		node->current = node->priority;
+
+		while (index != 0)
+		{
+			this->_join(index);
+			index = this->_node(index).parent;
+		}
+	}
+
+	uint32_t query(key_type constraint)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		// Perform a tree walk
+		uint32_t node = this->_root;
+		uint32_t final = 0;
+		uint32_t result = UINT32_MAX;
+
+		// Copy the find_* template
+		// Example gte
+#if 0
+		while (node != 0)
+		{
+			if (constraint <= this->_node(node).key)
+			{
+				result = MIN(result, this->_node(node).priority);
+
+				if (this->_node(node).right != 0)
+				{
+					result = MIN(result, this->_node(this->_node(node).right).current);
+				}
+
+				final = node;
+				node = this->_node(node).left;
+			}
+			else
+			{
+				node = this->_node(node).right;
+			}
+		}
+
+		if (final != 0)
+		{
+			if (this->_node(final).right != 0)
+			{
+				result = MIN(result, this->_node(this->_node(final).right).current);
+			}
+		}
+#endif
+
+		// Example lte
+#if 0
+		while (node != 0)
+		{
+			if (constraint < this->_node(node).key)
+			{
+
+				node = this->_node(node).left;
+			}
+			else
+			{
+				result = MIN(result, this->_node(node).priority);
+
+				if (this->_node(node).left != 0)
+				{
+					result = MIN(result, this->_node(this->_node(node).left).current);
+				}
+
+				final = node;
+				node = this->_node(node).right;
+			}
+		}
+
+		if (final != 0)
+		{
+			if (this->_node(final).left != 0)
+			{
+				result = MIN(result, this->_node(this->_node(final).left).current);
+			}
+		}
+#endif
+
+		return result;
+	}
+
+	// Combined priority of all keys in [low, high], the maximum value when there are none
+	priority_type aggregate(key_type low, key_type high)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		uint32_t node = this->_root;
+		priority_type result = numeric_limits<priority_type>::max();
+
+		// Find the topmost node inside the interval, both bounds split there
+		while (node != 0 && (this->_node(node).key < low || high < this->_node(node).key))
+		{
+			node = this->_node(node).key < low ? this->_node(node).right : this->_node(node).left;
+		}
+
+		if (node == 0)
+		{
+			return result;
+		}
+
+		result = this->_node(node).priority;
+
+		// Everything right of the lower path is inside
+		for (uint32_t temp = this->_node(node).left; temp != 0;)
+		{
+			if (this->_node(temp).key < low)
+			{
+				temp = this->_node(temp).right;
+				continue;
+			}
+
+			result = MIN(result, this->_node(temp).priority);
+
+			if (this->_node(temp).right != 0)
+			{
+				result = MIN(result, this->_node(this->_node(temp).right).current);
+			}
+
+			temp = this->_node(temp).left;
+		}
+
+		// Everything left of the upper path is inside
+		for (uint32_t temp = this->_node(node).right; temp != 0;)
+		{
+			if (high < this->_node(temp).key)
+			{
+				temp = this->_node(temp).left;
+				continue;
+			}
+
+			result = MIN(result, this->_node(temp).priority);
+
+			if (this->_node(temp).left != 0)
+			{
+				result = MIN(result, this->_node(this->_node(temp).left).current);
+			}
+
+			temp = this->_node(temp).right;
+		}
+
+		return result;
+	}
+
+	rbnode *find(key_type key)
+	{
+		uint32_t node = this->_root;
+
+		while (node != 0)
+		{
+			rbnode &current = this->_node(node);
+
+			if (key == current.key)
+			{
+				return &current;
+			}
+
+			if (key < current.key)
+			{
+				node = current.left;
+			}
+			else
+			{
+				node = current.right;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Get the node based on its rank
+	rbnode *get(uint32_t order)
+	{
+		uint32_t node = this->_root;
+
+		if (order >= this->_count)
+		{
+			return nullptr;
+		}
+
+		while (node != 0)
+		{
+			rbnode &current = this->_node(node);
+			uint32_t count = 1;
+
+			if (current.left != 0)
+			{
+				count += this->_node(current.left).size;
+			}
+
+			if (count == (order + 1))
+			{
+				return &current;
+			}
+
+			if (count > (order + 1))
+			{
+				node = current.left;
+			}
+			else
+			{
+				node = current.right;
+				order -= count;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Get the rank of node (0 based)
+	uint32_t order(rbnode *node)
+	{
+		uint32_t index = this->_index(node);
+		uint32_t count = 0;
+
+		if (index == 0)
+		{
+			return UINT32_MAX;
+		}
+
+		if (node->left != 0)
+		{
+			count += this->_node(node->left).size;
+		}
+
+		while (index != 0)
+		{
+			uint32_t parent = this->_node(index).parent;
+
+			if (parent != 0)
+			{
+				if (this->_node(parent).right == index)
+				{
+					count += 1;
+
+					if (this->_node(parent).left != 0)
+					{
+						count += this->_node(this->_node(parent).left).size;
+					}
+				}
+			}
+
+			index = parent;
+		}
+
+		return count;
+	}
+
+	uint8_t contains(key_type key)
+	{
+		return this->find(key) != nullptr;
+	}
+
+	uint32_t size()
+	{
+		return this->_count;
+	}
+
+	uint32_t _front()
+	{
+		uint32_t node = this->_root;
+
+		if (node == 0)
+		{
+			return 0;
+		}
+
+		while (this->_node(node).left != 0)
+		{
+			node = this->_node(node).left;
+		}
+
+		return node;
+	}
+
+	uint32_t _back()
+	{
+		uint32_t node = this->_root;
+
+		if (node == 0)
+		{
+			return 0;
+		}
+
+		while (this->_node(node).right != 0)
+		{
+			node = this->_node(node).right;
+		}
+
+		return node;
+	}
+
+	uint32_t _next(uint32_t index)
+	{
+		uint32_t temp = 0;
+
+		if (index == 0)
+		{
+			return 0;
+		}
+
+		if (this->_node(index).right != 0)
+		{
+			temp = this->_node(index).right;
+
+			while (this->_node(temp).left != 0)
+			{
+				temp = this->_node(temp).left;
+			}
+
+			return temp;
+		}
+
+		while (this->_node(index).parent != 0)
+		{
+			temp = this->_node(index).parent;
+
+			if (this->_node(temp).right == index)
+			{
+				index = temp;
+				continue;
+			}
+
+			return temp;
+		}
+
+		return 0;
+	}
+
+	uint32_t _prev(uint32_t index)
+	{
+		uint32_t temp = 0;
+
+		if (index == 0)
+		{
+			return 0;
+		}
+
+		if (this->_node(index).left != 0)
+		{
+			temp = this->_node(index).left;
+
+			while (this->_node(temp).right != 0)
+			{
+				temp = this->_node(temp).right;
+			}
+
+			return temp;
+		}
+
+		while (this->_node(index).parent != 0)
+		{
+			temp = this->_node(index).parent;
+
+			if (this->_node(temp).left == index)
+			{
+				index = temp;
+				continue;
+			}
+
+			return temp;
+		}
+
+		return 0;
+	}
 
 	// Get the first element
 	rbnode *front()
 	{
-		rbnode *node = this->_root;
+		return this->_ptr(this->_front());
+	}
+
+	// Get the last element
+	rbnode *back()
+	{
+		return this->_ptr(this->_back());
+	}
+
+	// Get the next element in order
+	rbnode *next(rbnode *node)
+	{
+		return this->_ptr(this->_next(this->_index(node)));
+	}
+
+	// Get the previous element in order
+	rbnode *prev(rbnode *node)
+	{
+		return this->_ptr(this->_prev(this->_index(node)));
+	}
+
+	// Bidirectional iterator over the nodes in order, end is index 0.
+	// Stays valid across modifications that do not erase its node.
+	struct iterator
+	{
+		using iterator_category = bidirectional_iterator_tag;
+		using value_type = rbnode;
+		using difference_type = ptrdiff_t;
+		using pointer = rbnode *;
+		using reference = rbnode &;
+
+		rbtree *tree = nullptr;
+		uint32_t index = 0;
+
+		reference operator*() const
+		{
+			return this->tree->_node(this->index);
+		}
+
+		pointer operator->() const
+		{
+			return &this->tree->_node(this->index);
+		}
+
+		iterator &operator++()
+		{
+			this->index = this->tree->_next(this->index);
+			return *this;
+		}
+
+		iterator operator++(int)
+		{
+			iterator temp = *this;
+			++*this;
+			return temp;
+		}
+
+		iterator &operator--()
+		{
+			// Stepping back from end gives the last element
+			this->index = this->index == 0 ? this->tree->_back() : this->tree->_prev(this->index);
+			return *this;
+		}
+
+		iterator operator--(int)
+		{
+			iterator temp = *this;
+			--*this;
+			return temp;
+		}
+
+		bool operator==(const iterator &other) const
+		{
+			return this->index == other.index;
+		}
+	};
+
+	iterator begin()
+	{
+		return {this, this->_front()};
+	}
+
+	iterator end()
+	{
+		return {this, 0};
+	}
+
+	// Iterator to a node returned by find, get, find_* and friends
+	iterator at(rbnode *node)
+	{
+		return {this, this->_index(node)};
+	}
+
+	// Find the largest key lesser than given key
+	rbnode *find_lt(key_type key)
+	{
+		uint32_t node = this->_root;
+		uint32_t result = 0;
+
+		while (node != 0)
+		{
+			if (key <= this->_node(node).key)
+			{
+				node = this->_node(node).left;
+			}
+			else
+			{
+				result = node;
+				node = this->_node(node).right;
+			}
+		}
+
+		return this->_ptr(result);
+	}
+
+	rbnode *find_lte(key_type key)
+	{
+		uint32_t node = this->_root;
+		uint32_t result = 0;
+
+		while (node != 0)
+		{
+			if (key < this->_node(node).key)
+			{
+				node = this->_node(node).left;
+			}
+			else
+			{
+				result = node;
+				node = this->_node(node).right;
+			}
+		}
+
+		return this->_ptr(result);
+	}
+
+	// Find the smallest key greater than given key
+	rbnode *find_gt(key_type key)
+	{
+		uint32_t node = this->_root;
+		uint32_t result = 0;
+
+		while (node != 0)
+		{
+			if (key < this->_node(node).key)
+			{
+				result = node;
+				node = this->_node(node).left;
+			}
+			else
+			{
+				node = this->_node(node).right;
+			}
+		}
+
+		return this->_ptr(result);
+	}
+
+	rbnode *find_gte(key_type key)
+	{
+		uint32_t node = this->_root;
+		uint32_t result = 0;
+
+		while (node != 0)
+		{
+			if (key <= this->_node(node).key)
+			{
+				result = node;
+				node = this->_node(node).left;
+			}
+			else
+			{
+				node = this->_node(node).right;
+			}
+		}
+
+		return this->_ptr(result);
+	}
+
+	// Count the number of elements lesser than given key
+	uint32_t count_lt(key_type key)
+	{
+		rbnode *node = this->find_lt(key);
+
+		if (node == nullptr)
+		{
+			return 0;
+		}
+
+		return this->order(node) + 1;
+	}
+
+	uint32_t count_lte(key_type key)
+	{
+		rbnode *node = this->find_lte(key);
+
+		if (node == nullptr)
+		{
+			return 0;
+		}
+
+		return this->order(node) + 1;
+	}
+
+	// Count the number of elements greater than given key
+	uint32_t count_gt(key_type key)
+	{
+		rbnode *node = this->find_gt(key);
+
+		if (node == nullptr)
+		{
+			return 0;
+		}
+
+		return this->size() - this->order(node);
+	}
+
+	uint32_t count_gte(key_type key)
+	{
+		rbnode *node = this->find_gte(key);
+
+		if (node == nullptr)
+		{
+			return 0;
+		}
+
+		return this->size() - this->order(node);
+	}
+};
+
+// Path copying red-black tree, every update copies the O(log n) nodes it touches and returns a new version.
+// Versions are handles into roots, version 0 is the empty tree and old versions are never modified.
+template <typename KEY, typename VALUE = void, typename PRIORITY = void, bool DUPLICATES = false>
+struct persistent_rbtree
+{
+	using key_type = KEY;
+	using value_type = VALUE;
+	using priority_type = PRIORITY;
+
+	// Same node layouts as rbtree without the parent link
+	using rbnode = typename rbtree<KEY, VALUE, PRIORITY, DUPLICATES>::template rbnode_select<
+		typename rbtree<KEY, VALUE, PRIORITY, DUPLICATES>::rblinks_persistent>;
+
+	// Deep enough for 2^32 keys, paths can grow by one during erase fixup
+	static constexpr uint32_t _depth = 2 * 32 + 2;
+
+	vector<rbnode> _nodes;  // all nodes, index 0 is null
+	vector<uint32_t> roots; // root of every version
+
+	persistent_rbtree()
+	{
+		this->_nodes.resize(1);
+		this->roots.push_back(0);
+	}
+
+	rbnode &_node(uint32_t index)
+	{
+		return this->_nodes[index];
+	}
+
+	uint32_t _alloc_node()
+	{
+		uint32_t index = this->_nodes.size();
+
+		this->_nodes.emplace_back();
+		this->_node(index).size = 1;
+		this->_node(index).color = 1;
+
+		return index;
+	}
+
+	// Private copy of a possibly shared node
+	uint32_t _copy(uint32_t index)
+	{
+		if (index == 0)
+		{
+			return 0;
+		}
+
+		this->_nodes.push_back(this->_nodes[index]);
+
+		return this->_nodes.size() - 1;
+	}
+
+	bool _color(uint32_t index)
+	{
+		// Undefined nodes are always black
+		if (index == 0)
+		{
+			return 0;
+		}
+
+		return this->_node(index).color;
+	}
+
+	priority_type _priority(uint32_t index)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		// Assign priority based on value or key here
+		return 0;
+	}
+
+	void _size(uint32_t index)
+	{
+		uint32_t count = 1;
+
+		if (index == 0)
+		{
+			return;
+		}
+
+		rbnode &n = this->_node(index);
+
+		count += n.left != 0 ? this->_node(n.left).size : 0;
+		count += n.right != 0 ? this->_node(n.right).size : 0;
+
+		n.size = count;
+	}
+
+	void _join(uint32_t index)
+	{
+		if constexpr (!is_same_v<PRIORITY, void>)
+		{
+			rbnode &node = this->_node(index);
+
+			node.priority = this->_priority(index);
+			node.current = node.priority;
+
+			if (node.left != 0)
+			{
+				node.current = MIN(node.current, this->_node(node.left).current);
+			}
+
+			if (node.right != 0)
+			{
+				node.current = MIN(node.current, this->_node(node.right).current);
+			}
+		}
+	}
+
+	// Point the link of parent (or the root) that held from at to
+	void _relink(uint32_t parent, uint32_t from, uint32_t to, uint32_t &root)
+	{
+		if (parent == 0)
+		{
+			root = to;
+		}
+		else if (this->_node(parent).left == from)
+		{
+			this->_node(parent).left = to;
+		}
+		else
+		{
+			this->_node(parent).right = to;
+		}
+	}
+
+	// Rotations only touch x, its child on the rotating side and the parent link,
+	// all of them must already be private copies
+	void _left_rotate(uint32_t x, uint32_t parent, uint32_t &root)
+	{
+		uint32_t y = this->_node(x).right;
+
+		this->_node(x).right = this->_node(y).left;
+		this->_node(y).left = x;
+		this->_relink(parent, x, y, root);
+
+		this->_size(x);
+		this->_join(x);
+
+		this->_size(y);
+		this->_join(y);
+	}
+
+	void _right_rotate(uint32_t x, uint32_t parent, uint32_t &root)
+	{
+		uint32_t y = this->_node(x).left;
+
+		this->_node(x).left = this->_node(y).right;
+		this->_node(y).right = x;
+		this->_relink(parent, x, y, root);
+
+		this->_size(x);
+		this->_join(x);
+
+		this->_size(y);
+		this->_join(y);
+	}
+
+	// Refresh statistics on a copied path bottom up
+	void _update_path(const array<uint32_t, _depth> &path, uint32_t depth)
+	{
+		while (depth != 0)
+		{
+			depth -= 1;
+
+			this->_size(path[depth]);
+			this->_join(path[depth]);
+		}
+	}
+
+	void _insert_fixup(array<uint32_t, _depth> &path, uint32_t depth, uint32_t &root)
+	{
+		// Same cases as rbtree, the path stands in for the parent links
+		// and the uncle is copied before it is recolored
+		while (depth >= 3 && this->_color(path[depth - 2]))
+		{
+			uint32_t node = path[depth - 1];
+			uint32_t parent = path[depth - 2];
+			uint32_t grandparent = path[depth - 3];
+			uint32_t above = depth >= 4 ? path[depth - 4] : 0;
+			uint32_t uncle = 0;
+
+			if (parent == this->_node(grandparent).left)
+			{
+				uncle = this->_node(grandparent).right;
+
+				if (this->_color(uncle))
+				{
+					uncle = this->_copy(uncle);
+					this->_node(grandparent).right = uncle;
+
+					this->_node(parent).color = 0;
+					this->_node(uncle).color = 0;
+					this->_node(grandparent).color = 1;
+
+					depth -= 2;
+				}
+				else
+				{
+					if (node == this->_node(parent).right)
+					{
+						this->_left_rotate(parent, grandparent, root);
+						parent = node;
+					}
+
+					this->_node(parent).color = 0;
+					this->_node(grandparent).color = 1;
+
+					this->_right_rotate(grandparent, above, root);
+
+					break;
+				}
+			}
+			else
+			{
+				uncle = this->_node(grandparent).left;
+
+				if (this->_color(uncle))
+				{
+					uncle = this->_copy(uncle);
+					this->_node(grandparent).left = uncle;
+
+					this->_node(parent).color = 0;
+					this->_node(uncle).color = 0;
+					this->_node(grandparent).color = 1;
+
+					depth -= 2;
+				}
+				else
+				{
+					if (node == this->_node(parent).left)
+					{
+						this->_right_rotate(parent, grandparent, root);
+						parent = node;
+					}
+
+					this->_node(parent).color = 0;
+					this->_node(grandparent).color = 1;
+
+					this->_left_rotate(grandparent, above, root);
+
+					break;
+				}
+			}
+		}
+
+		this->_node(root).color = 0;
+	}
+
+	// Copy the search path for key, assign(node) fills in the new or existing node
+	template <typename FUNCTION>
+	uint32_t _insert(uint32_t version, key_type key, FUNCTION &&assign)
+	{
+		array<uint32_t, _depth> path;
+		uint32_t depth = 0;
+		uint32_t root = this->_copy(this->roots[version]);
+		uint32_t node = root;
 
-		if (node == nullptr)
+		while (node != 0)
 		{
-			return nullptr;
+			path[depth++] = node;
+
+			if constexpr (DUPLICATES == false)
+			{
+				if (key == this->_node(node).key)
+				{
+					assign(node);
+					this->_update_path(path, depth);
+					this->roots.push_back(root);
+
+					return this->roots.size() - 1;
+				}
+			}
+
+			uint8_t left = key < this->_node(node).key;
+			uint32_t child = this->_copy(left ? this->_node(node).left : this->_node(node).right);
+
+			if (left)
+			{
+				this->_node(node).left = child;
+			}
+			else
+			{
+				this->_node(node).right = child;
+			}
+
+			node = child;
 		}
 
-		while (node->left != nullptr)
+		node = this->_alloc_node();
+		this->_node(node).key = key;
+		assign(node);
+
+		if (depth == 0)
+		{
+			root = node;
+		}
+		else if (key < this->_node(path[depth - 1]).key)
 		{
-			node = node->left;
+			this->_node(path[depth - 1]).left = node;
+		}
+		else
+		{
+			this->_node(path[depth - 1]).right = node;
 		}
 
-		return node;
+		path[depth++] = node;
+
+		this->_update_path(path, depth);
+		this->_insert_fixup(path, depth, root);
+		this->roots.push_back(root);
+
+		return this->roots.size() - 1;
 	}
 
-	// Get the last element
-	rbnode *back()
+	// Insert into a version and return the new version
+	uint32_t insert(uint32_t version, key_type key)
 	{
-		rbnode *node = this->_root;
+		return this->_insert(version, key, [](uint32_t) {});
+	}
 
-		if (node == nullptr)
+	template <typename TYPE>
+	uint32_t insert(uint32_t version, key_type key, TYPE value)
+		requires(!std::is_same_v<VALUE, void>)
+	{
+		return this->_insert(version, key, [&](uint32_t node) { this->_node(node).value = value; });
+	}
+
+	void _erase_fixup(array<uint32_t, _depth> &path, uint32_t depth, uint32_t successor, uint32_t &root)
+	{
+		// Same cases as rbtree, path[depth - 1] is the parent of successor.
+		// The sibling and its children are copied before they are recolored or rotated.
+		while (successor != root && this->_color(successor) == 0)
 		{
-			return nullptr;
+			uint32_t parent = path[depth - 1];
+			uint32_t above = depth >= 2 ? path[depth - 2] : 0;
+			uint32_t sibling = 0;
+
+			if (successor == this->_node(parent).left)
+			{
+				sibling = this->_copy(this->_node(parent).right);
+				this->_node(parent).right = sibling;
+
+				if (this->_color(sibling))
+				{
+					this->_node(sibling).color = 0;
+					this->_node(parent).color = 1;
+
+					// The sibling moves above parent on the path
+					this->_left_rotate(parent, above, root);
+					path[depth - 1] = sibling;
+					path[depth++] = parent;
+					above = sibling;
+
+					sibling = this->_copy(this->_node(parent).right);
+					this->_node(parent).right = sibling;
+				}
+
+				if (this->_color(this->_node(sibling).left) == 0 && this->_color(this->_node(sibling).right) == 0)
+				{
+					this->_node(sibling).color = 1;
+
+					successor = parent;
+					depth -= 1;
+				}
+				else
+				{
+					if (this->_color(this->_node(sibling).right) == 0)
+					{
+						this->_node(sibling).left = this->_copy(this->_node(sibling).left);
+						this->_node(this->_node(sibling).left).color = 0;
+						this->_node(sibling).color = 1;
+
+						this->_right_rotate(sibling, parent, root);
+						sibling = this->_node(parent).right;
+					}
+
+					this->_node(sibling).right = this->_copy(this->_node(sibling).right);
+					this->_node(sibling).color = this->_node(parent).color;
+					this->_node(parent).color = 0;
+					this->_node(this->_node(sibling).right).color = 0;
+
+					this->_left_rotate(parent, above, root);
+					successor = root;
+					break;
+				}
+			}
+			else
+			{
+				sibling = this->_copy(this->_node(parent).left);
+				this->_node(parent).left = sibling;
+
+				if (this->_color(sibling))
+				{
+					this->_node(sibling).color = 0;
+					this->_node(parent).color = 1;
+
+					this->_right_rotate(parent, above, root);
+					path[depth - 1] = sibling;
+					path[depth++] = parent;
+					above = sibling;
+
+					sibling = this->_copy(this->_node(parent).left);
+					this->_node(parent).left = sibling;
+				}
+
+				if (this->_color(this->_node(sibling).left) == 0 && this->_color(this->_node(sibling).right) == 0)
+				{
+					this->_node(sibling).color = 1;
+
+					successor = parent;
+					depth -= 1;
+				}
+				else
+				{
+					if (this->_color(this->_node(sibling).left) == 0)
+					{
+						this->_node(sibling).right = this->_copy(this->_node(sibling).right);
+						this->_node(this->_node(sibling).right).color = 0;
+						this->_node(sibling).color = 1;
+
+						this->_left_rotate(sibling, parent, root);
+						sibling = this->_node(parent).left;
+					}
+
+					this->_node(sibling).left = this->_copy(this->_node(sibling).left);
+					this->_node(sibling).color = this->_node(parent).color;
+					this->_node(parent).color = 0;
+					this->_node(this->_node(sibling).left).color = 0;
+
+					this->_right_rotate(parent, above, root);
+					successor = root;
+					break;
+				}
+			}
 		}
 
-		while (node->right != nullptr)
+		// successor is a private copy whenever it is red
+		if (successor != 0)
 		{
-			node = node->right;
+			this->_node(successor).color = 0;
 		}
-
-		return node;
 	}
 
-	// Get the next element in order
-	rbnode *next(rbnode *node)
+	// Erase one occurrence of key from a version and return the new version
+	uint32_t erase(uint32_t version, key_type key)
 	{
-		rbnode *temp = nullptr;
+		array<uint32_t, _depth> path;
+		uint32_t depth = 0;
+		uint32_t root = 0;
+		uint32_t node = 0;
 
-		if (node == nullptr || node == nullptr)
+		if (this->find(version, key) == nullptr)
 		{
-			return nullptr;
+			this->roots.push_back(this->roots[version]);
+			return this->roots.size() - 1;
 		}
 
-		if (node->right != nullptr)
+		root = this->_copy(this->roots[version]);
+		node = root;
+
+		// Copy the search path down to the key
+		while (!(key == this->_node(node).key))
 		{
-			temp = node->right;
+			path[depth++] = node;
+
+			uint8_t left = key < this->_node(node).key;
+			uint32_t child = this->_copy(left ? this->_node(node).left : this->_node(node).right);
 
-			while (temp->left != nullptr)
+			if (left)
+			{
+				this->_node(node).left = child;
+			}
+			else
 			{
-				temp = temp->left;
+				this->_node(node).right = child;
 			}
 
-			return temp;
+			node = child;
 		}
 
-		while (node->parent != nullptr)
+		path[depth++] = node;
+
+		// With two children, move the successor's payload up and remove the successor instead
+		if (this->_node(node).left != 0 && this->_node(node).right != 0)
 		{
-			temp = node->parent;
+			uint32_t target = node;
+			uint32_t min = this->_copy(this->_node(node).right);
+
+			this->_node(node).right = min;
+			path[depth++] = min;
 
-			if (temp->right == node)
+			while (this->_node(min).left != 0)
 			{
-				node = temp;
-				continue;
+				uint32_t child = this->_copy(this->_node(min).left);
+
+				this->_node(min).left = child;
+				path[depth++] = child;
+				min = child;
 			}
 
-			return temp;
+			uint32_t left = this->_node(target).left;
+			uint32_t right = this->_node(target).right;
+			uint8_t color = this->_node(target).color;
+
+			this->_node(target) = this->_node(min);
+			this->_node(target).left = left;
+			this->_node(target).right = right;
+			this->_node(target).color = color;
+
+			node = min;
+		}
+
+		// node has at most one child, which takes its place
+		uint32_t successor = this->_copy(this->_node(node).left != 0 ? this->_node(node).left : this->_node(node).right);
+		uint8_t color = this->_node(node).color;
+
+		depth -= 1;
+		this->_relink(depth != 0 ? path[depth - 1] : 0, node, successor, root);
+
+		this->_update_path(path, depth);
+
+		if (color == 0)
+		{
+			this->_erase_fixup(path, depth, successor, root);
+		}
+
+		this->roots.push_back(root);
+
+		return this->roots.size() - 1;
+	}
+
+	uint32_t size(uint32_t version)
+	{
+		uint32_t root = this->roots[version];
+
+		return root != 0 ? this->_node(root).size : 0;
+	}
+
+	// Node pointers stay valid until the next update
+	const rbnode *find(uint32_t version, key_type key)
+	{
+		uint32_t node = this->roots[version];
+
+		while (node != 0)
+		{
+			if (key == this->_node(node).key)
+			{
+				return &this->_node(node);
+			}
+
+			node = key < this->_node(node).key ? this->_node(node).left : this->_node(node).right;
 		}
 
 		return nullptr;
 	}
 
-	// Get the previous element in order
-	rbnode *prev(rbnode *node)
+	uint8_t contains(uint32_t version, key_type key)
 	{
-		rbnode *temp = nullptr;
+		return this->find(version, key) != nullptr;
+	}
 
-		if (node == nullptr)
+	// Get the node based on its rank
+	const rbnode *get(uint32_t version, uint32_t order)
+	{
+		uint32_t node = this->roots[version];
+
+		if (order >= this->size(version))
 		{
 			return nullptr;
 		}
 
-		if (node->left != nullptr)
+		while (node != 0)
 		{
-			temp = node->left;
+			uint32_t count = 1;
 
-			while (temp->right != nullptr)
+			if (this->_node(node).left != 0)
 			{
-				temp = temp->right;
+				count += this->_node(this->_node(node).left).size;
 			}
 
-			return temp;
-		}
-
-		while (node->parent != nullptr)
-		{
-			temp = node->parent;
-
-			if (temp->left == node)
+			if (count == (order + 1))
 			{
-				node = temp;
-				continue;
+				return &this->_node(node);
 			}
 
-			return temp;
+			if (count > (order + 1))
+			{
+				node = this->_node(node).left;
+			}
+			else
+			{
+				node = this->_node(node).right;
+				order -= count;
+			}
 		}
 
 		return nullptr;
 	}
 
 	// Find the largest key lesser than given key
-	rbnode *find_lt(key_type key)
+	const rbnode *find_lt(uint32_t version, key_type key)
 	{
-		rbnode *node = this->_root;
-		rbnode *result = nullptr;
+		uint32_t node = this->roots[version];
+		uint32_t result = 0;
 
-		while (node != nullptr)
+		while (node != 0)
 		{
-			if (key <= node->key)
+			if (key <= this->_node(node).key)
 			{
-				node = node->left;
+				node = this->_node(node).left;
 			}
 			else
 			{
 				result = node;
-				node = node->right;
+				node = this->_node(node).right;
 			}
 		}
 
-		return result;
+		return result != 0 ? &this->_node(result) : nullptr;
 	}
 
-	rbnode *find_lte(key_type key)
+	const rbnode *find_lte(uint32_t version, key_type key)
 	{
-		rbnode *node = this->_root;
-		rbnode *result = nullptr;
+		uint32_t node = this->roots[version];
+		uint32_t result = 0;
 
-		while (node != nullptr)
+		while (node != 0)
 		{
-			if (key < node->key)
+			if (key < this->_node(node).key)
 			{
-				node = node->left;
+				node = this->_node(node).left;
 			}
 			else
 			{
 				result = node;
-				node = node->right;
+				node = this->_node(node).right;
 			}
 		}
 
-		return result;
+		return result != 0 ? &this->_node(result) : nullptr;
 	}
 
 	// Find the smallest key greater than given key
-	rbnode *find_gt(key_type key)
+	const rbnode *find_gt(uint32_t version, key_type key)
 	{
-		rbnode *node = this->_root;
-		rbnode *result = nullptr;
+		uint32_t node = this->roots[version];
+		uint32_t result = 0;
 
-		while (node != nullptr)
+		while (node != 0)
 		{
-			if (key < node->key)
+			if (key < this->_node(node).key)
 			{
 				result = node;
-				node = node->left;
+				node = this->_node(node).left;
 			}
 			else
 			{
-				node = node->right;
+				node = this->_node(node).right;
 			}
 		}
 
-		return result;
+		return result != 0 ? &this->_node(result) : nullptr;
 	}
 
-	rbnode *find_gte(key_type key)
+	const rbnode *find_gte(uint32_t version, key_type key)
 	{
-		rbnode *node = this->_root;
-		rbnode *result = nullptr;
+		uint32_t node = this->roots[version];
+		uint32_t result = 0;
 
-		while (node != nullptr)
+		while (node != 0)
 		{
-			if (key <= node->key)
+			if (key <= this->_node(node).key)
 			{
 				result = node;
-				node = node->left;
+				node = this->_node(node).left;
 			}
 			else
 			{
-				node = node->right;
+				node = this->_node(node).right;
 			}
 		}
 
-		return result;
+		return result != 0 ? &this->_node(result) : nullptr;
 	}
 
-	// Count the number of elements lesser than given key
-	uint32_t count_lt(key_type key)
+	// Count the number of elements lesser than given key (or not greater when INCLUSIVE)
+	template <bool INCLUSIVE>
+	uint32_t _count(uint32_t version, key_type key)
 	{
-		rbnode *node = this->find_lt(key);
+		uint32_t node = this->roots[version];
+		uint32_t result = 0;
 
-		if (node == nullptr)
+		while (node != 0)
 		{
-			return 0;
+			if (INCLUSIVE ? key < this->_node(node).key : key <= this->_node(node).key)
+			{
+				node = this->_node(node).left;
+			}
+			else
+			{
+				result += 1;
+
+				if (this->_node(node).left != 0)
+				{
+					result += this->_node(this->_node(node).left).size;
+				}
+
+				node = this->_node(node).right;
+			}
 		}
 
-		return this->order(node) + 1;
+		return result;
 	}
 
-	uint32_t count_lte(key_type key)
+	uint32_t count_lt(uint32_t version, key_type key)
 	{
-		rbnode *node = this->find_lte(key);
-
-		if (node == nullptr)
-		{
-			return 0;
-		}
+		return this->_count<false>(version, key);
+	}
 
-		return this->order(node) + 1;
+	uint32_t count_lte(uint32_t version, key_type key)
+	{
+		return this->_count<true>(version, key);
 	}
 
 	// Count the number of elements greater than given key
-	uint32_t count_gt(key_type key)
+	uint32_t count_gt(uint32_t version, key_type key)
 	{
-		rbnode *node = this->find_gt(key);
+		return this->size(version) - this->_count<true>(version, key);
+	}
 
-		if (node == nullptr)
+	uint32_t count_gte(uint32_t version, key_type key)
+	{
+		return this->size(version) - this->_count<false>(version, key);
+	}
+
+	// Combined priority of all keys in [low, high] of a version, the maximum value when there are none
+	priority_type aggregate(uint32_t version, key_type low, key_type high)
+		requires(!std::is_same_v<PRIORITY, void>)
+	{
+		uint32_t node = this->roots[version];
+		priority_type result = numeric_limits<priority_type>::max();
+
+		while (node != 0 && (this->_node(node).key < low || high < this->_node(node).key))
 		{
-			return 0;
+			node = this->_node(node).key < low ? this->_node(node).right : this->_node(node).left;
 		}
 
-		return this->size() - this->order(node);
-	}
+		if (node == 0)
+		{
+			return result;
+		}
 
-	uint32_t count_gte(key_type key)
-	{
-		rbnode *node = this->find_gte(key);
+		result = this->_node(node).priority;
 
-		if (node == nullptr)
+		for (uint32_t temp = this->_node(node).left; temp != 0;)
 		{
-			return 0;
+			if (this->_node(temp).key < low)
+			{
+				temp = this->_node(temp).right;
+				continue;
+			}
+
+			result = MIN(result, this->_node(temp).priority);
+
+			if (this->_node(temp).right != 0)
+			{
+				result = MIN(result, this->_node(this->_node(temp).right).current);
+			}
+
+			temp = this->_node(temp).left;
 		}
 
-		return this->size() - this->order(node);
+		for (uint32_t temp = this->_node(node).right; temp != 0;)
+		{
+			if (high < this->_node(temp).key)
+			{
+				temp = this->_node(temp).left;
+				continue;
+			}
+
+			result = MIN(result, this->_node(temp).priority);
+
+			if (this->_node(temp).left != 0)
+			{
+				result = MIN(result, this->_node(this->_node(temp).left).current);
+			}
+
+			temp = this->_node(temp).right;
+		}
+
+		return result;
+	}
+
+	void clear()
+	{
+		this->_nodes.resize(1);
+		this->roots.assign(1, 0);
 	}
 };
 
@@ -1312,3 +2801,15 @@ using augmented_map = rbtree<KEY, VALUE, PRIORITY, false>;
 
 template <typename KEY, typename VALUE, typename PRIORITY>
 using augmented_multimap = rbtree<KEY, VALUE, PRIORITY, true>;
+
+template <typename KEY>
+using persistent_ordered_set = persistent_rbtree<KEY, void, void, false>;
+
+template <typename KEY>
+using persistent_ordered_multiset = persistent_rbtree<KEY, void, void, true>;
+
+template <typename KEY, typename VALUE>
+using persistent_ordered_map = persistent_rbtree<KEY, VALUE, void, false>;
+
+template <typename KEY, typename VALUE>
+using persistent_ordered_multimap = persistent_rbtree<KEY, VALUE, void, true>;
@@ -14,12 +14,20 @@ concept segtree_operator_ext = requires(O op, T a, L b, uint32_t r) {
 	};
 } && segtree_operator<O, T>;
 
+// Segment tree beats
+// skip -> break condition, the update does not change any element of the node
+// fail -> tag condition, the update can not be applied to the node as a whole
+template <typename O, typename T, typename L>
+concept segtree_operator_beats = requires(O op, T a, L b) {
+	{ op.skip(a, b) } -> std::same_as<bool>;
+	{ op.fail(a, b) } -> std::same_as<bool>;
+} && segtree_operator_ext<O, T, L>;
+
 template <typename T, typename O>
 	requires segtree_operator<O, T>
 struct simple_segment_tree
 {
 	vector<T> tree;
-	stack<array<uint32_t, 3>> st;
 
 	uint32_t offset;
 	uint32_t size;
@@ -89,9 +97,41 @@ struct simple_segment_tree
 		}
 	}
 
+	template <typename U>
+	void update_many(const vector<pair<uint32_t, U>> &updates)
+	{
+		uint32_t depth = 32 - __builtin_clz(this->nearest);
+
+		// Walk each path when there are only a few updates
+		if (updates.size() * depth < this->offset)
+		{
+			for (const auto &[index, value] : updates)
+			{
+				this->update(index, value);
+			}
+
+			return;
+		}
+
+		// Otherwise rebuilding everything is cheaper
+		for (const auto &[index, value] : updates)
+		{
+			if (index < this->size)
+			{
+				this->tree[index + this->offset] = this->op.assign(value, index);
+			}
+		}
+
+		for (uint32_t i = this->offset; i != 0; --i)
+		{
+			this->_join(i - 1);
+		}
+	}
+
 	T query(uint32_t left, uint32_t right)
 	{
-		T value = this->op.identity();
+		T left_value = this->op.identity();
+		T right_value = this->op.identity();
 
 		if (left > this->size)
 		{
@@ -103,31 +143,140 @@ struct simple_segment_tree
 			right = this->size - 1;
 		}
 
-		this->st.push({0, 0, this->nearest - 1});
+		// Walk up from the leaves using 1 based indices, [left, right)
+		left += this->nearest;
+		right += this->nearest + 1;
 
-		while (this->st.size() != 0)
+		while (left < right)
 		{
-			auto [index, current_left, current_right] = this->st.top();
-			uint32_t middle = (current_left + current_right) / 2;
+			if (left & 1)
+			{
+				left_value = this->op.join(left_value, this->tree[left - 1]);
+				left += 1;
+			}
 
-			this->st.pop();
+			if (right & 1)
+			{
+				right -= 1;
+				right_value = this->op.join(this->tree[right - 1], right_value);
+			}
 
-			if (current_right < left || current_left > right)
+			left >>= 1;
+			right >>= 1;
+		}
+
+		return this->op.join(left_value, right_value);
+	}
+
+	vector<T> query_many(const vector<pair<uint32_t, uint32_t>> &ranges)
+	{
+		vector<T> result;
+
+		result.reserve(ranges.size());
+
+		for (const auto &[left, right] : ranges)
+		{
+			result.push_back(this->query(left, right));
+		}
+
+		return result;
+	}
+
+	// First index r >= left where pred(join(left..r)) fails, size if it never fails
+	// pred should be monotone and hold for the identity
+	template <typename P>
+	uint32_t max_right(uint32_t left, P pred)
+	{
+		T value = this->op.identity();
+		uint32_t index = 0;
+
+		if (left >= this->size)
+		{
+			return this->size;
+		}
+
+		// 1 based index of the leaf
+		index = left + this->nearest;
+
+		do
+		{
+			while ((index & 1) == 0)
 			{
-				continue;
+				index >>= 1;
 			}
 
-			if (current_left >= left && current_right <= right)
+			if (!pred(this->op.join(value, this->tree[index - 1])))
 			{
-				value = this->op.join(this->tree[index], value);
-				continue;
+				// Descend to the leaf where the predicate fails
+				while (index < this->nearest)
+				{
+					index <<= 1;
+
+					if (pred(this->op.join(value, this->tree[index - 1])))
+					{
+						value = this->op.join(value, this->tree[index - 1]);
+						index += 1;
+					}
+				}
+
+				return MIN(index - this->nearest, this->size);
 			}
 
-			this->st.push({(index * 2) + 1, current_left, middle});
-			this->st.push({(index * 2) + 2, middle + 1, current_right});
+			value = this->op.join(value, this->tree[index - 1]);
+			index += 1;
+
+		} while ((index & (index - 1)) != 0);
+
+		return this->size;
+	}
+
+	// Last index l <= right where pred(join(l..right)) fails, UINT32_MAX if it never fails
+	// pred should be monotone and hold for the identity
+	template <typename P>
+	uint32_t min_left(uint32_t right, P pred)
+	{
+		T value = this->op.identity();
+		uint32_t index = 0;
+
+		if (right >= this->size)
+		{
+			right = this->size - 1;
 		}
 
-		return value;
+		// 1 based index one past the leaf
+		index = right + this->nearest + 1;
+
+		do
+		{
+			index -= 1;
+
+			while (index > 1 && (index & 1))
+			{
+				index >>= 1;
+			}
+
+			if (!pred(this->op.join(this->tree[index - 1], value)))
+			{
+				// Descend to the leaf where the predicate fails
+				while (index < this->nearest)
+				{
+					index = (index << 1) + 1;
+
+					if (pred(this->op.join(this->tree[index - 1], value)))
+					{
+						value = this->op.join(this->tree[index - 1], value);
+						index -= 1;
+					}
+				}
+
+				return index - this->nearest;
+			}
+
+			value = this->op.join(this->tree[index - 1], value);
+
+		} while ((index & (index - 1)) != 0);
+
+		return UINT32_MAX;
 	}
 };
 
@@ -249,11 +398,32 @@ struct lazy_segment_tree
 				continue;
 			}
 
+			if constexpr (segtree_operator_beats<O, T, L>)
+			{
+				// None of the elements are affected
+				if (this->op.skip(this->tree[index], element))
+				{
+					continue;
+				}
+			}
+
 			if (current_left >= left && current_right <= right)
 			{
-				// For beats
-				// Determine when all of the nodes are affected
-				// Determine when none of the nodes are affected
+				if constexpr (segtree_operator_beats<O, T, L>)
+				{
+					// Not all of the elements are affected in the same way, split further
+					if (index < this->offset && this->op.fail(this->tree[index], element))
+					{
+						this->_push(index);
+						this->up.push(index);
+
+						this->st.push({(index * 2) + 1, current_left, middle});
+						this->st.push({(index * 2) + 2, middle + 1, current_right});
+
+						continue;
+					}
+				}
+
 				this->_apply(index, element);
 				continue;
 			}
@@ -317,6 +487,119 @@ struct lazy_segment_tree
 
 		return result;
 	}
+
+	// First index r >= left where pred(join(left..r)) fails, size if it never fails
+	// pred should be monotone and hold for the identity
+	template <typename P>
+	uint32_t max_right(uint32_t left, P pred)
+	{
+		T value = this->op.identity();
+		uint32_t index = 0;
+		uint32_t depth = __builtin_ctz(this->nearest);
+
+		if (left >= this->size)
+		{
+			return this->size;
+		}
+
+		// 1 based index of the leaf
+		index = left + this->nearest;
+
+		// Push the updates on the path to the leaf
+		for (uint32_t i = depth; i != 0; --i)
+		{
+			this->_push((index >> i) - 1);
+		}
+
+		do
+		{
+			while ((index & 1) == 0)
+			{
+				index >>= 1;
+			}
+
+			if (!pred(this->op.join(value, this->tree[index - 1])))
+			{
+				// Descend to the leaf where the predicate fails
+				while (index < this->nearest)
+				{
+					this->_push(index - 1);
+					index <<= 1;
+
+					if (pred(this->op.join(value, this->tree[index - 1])))
+					{
+						value = this->op.join(value, this->tree[index - 1]);
+						index += 1;
+					}
+				}
+
+				return MIN(index - this->nearest, this->size);
+			}
+
+			value = this->op.join(value, this->tree[index - 1]);
+			index += 1;
+
+		} while ((index & (index - 1)) != 0);
+
+		return this->size;
+	}
+
+	// Last index l <= right where pred(join(l..right)) fails, UINT32_MAX if it never fails
+	// pred should be monotone and hold for the identity
+	template <typename P>
+	uint32_t min_left(uint32_t right, P pred)
+	{
+		T value = this->op.identity();
+		uint32_t index = 0;
+		uint32_t depth = __builtin_ctz(this->nearest);
+
+		if (right >= this->size)
+		{
+			right = this->size - 1;
+		}
+
+		// 1 based index one past the leaf
+		index = right + this->nearest + 1;
+
+		// Push the updates on the path to the leaf
+		for (uint32_t i = depth; i != 0; --i)
+		{
+			this->_push(((index - 1) >> i) - 1);
+		}
+
+		do
+		{
+			index -= 1;
+
+			while (index > 1 && (index & 1))
+			{
+				index >>= 1;
+			}
+
+			if (!pred(this->op.join(this->tree[index - 1], value)))
+			{
+				// Descend to the leaf where the predicate fails
+				while (index < this->nearest)
+				{
+					this->_push(index - 1);
+					index = (index << 1) + 1;
+
+					if (pred(this->op.join(this->tree[index - 1], value)))
+					{
+						value = this->op.join(this->tree[index - 1], value);
+						index -= 1;
+					}
+				}
+
+				return index - this->nearest;
+			}
+
+			value = this->op.join(this->tree[index - 1], value);
+
+		} while ((index & (index - 1)) != 0);
+
+		return UINT32_MAX;
+	}
 };
 
 template <typename T, typename L, typename O>
@@ -325,22 +608,13 @@ struct sparse_segment_tree
 {
 	using range_t = uint32_t;
 
-	struct node
-	{
-		range_t begin, end;   // responsibility
-		uint32_t left, right; // children
-
-		node()
-		{
-			begin = 0, end = 0, left = 0, right = 0;
-		}
-	};
-
-	vector<node> info;
+	// Nodes only store their children, the responsibility is derived on descent.
+	// Children are allocated as a pair, the right child always follows the left child.
+	vector<uint32_t> children; // left child, 0 if not created
 	vector<T> tree;
 	vector<L> lazy;
 
-	stack<uint32_t> st;
+	stack<array<uint32_t, 3>> st;
 	stack<uint32_t> up;
 
 	range_t begin;
@@ -350,120 +624,93 @@ struct sparse_segment_tree
 
 	void _join(uint32_t index)
 	{
-		if (this->_leaf(index))
+		uint32_t left = this->children[index];
+
+		if (left == 0)
 		{
 			return;
 		}
 
 		// Join here
-		this->tree[index] = this->op.join(this->tree[this->info[index].left], this->tree[this->info[index].right]);
+		this->tree[index] = this->op.join(this->tree[left], this->tree[left + 1]);
 	}
 
-	void _apply(uint32_t index, const L &element)
+	void _apply(uint32_t index, const L &element, range_t begin, range_t end)
 		requires(!std::is_empty_v<L>)
 	{
 		// Apply to current node
-		this->tree[index] = this->op.apply(this->tree[index], element, this->info[index].begin, this->info[index].end);
+		this->tree[index] = this->op.apply(this->tree[index], element, begin, end);
 
 		// Push to children
 		this->lazy[index] = this->op.compose(this->lazy[index], element);
 	}
 
-	bool _leaf(uint32_t index)
+	void _node()
 	{
-		if (this->info[index].begin == this->info[index].end)
+		this->children.push_back(0);
+		this->tree.push_back(this->op.identity());
+
+		if constexpr (!std::is_empty_v<L>)
 		{
-			return true;
+			this->lazy.push_back(this->op.reset());
 		}
-
-		return false;
 	}
 
-	void _create(uint32_t index)
+	void _create(uint32_t index, range_t begin, range_t end)
 	{
-		node left = {}, right = {};
-
-		if (this->_leaf(index))
+		if (begin == end)
 		{
 			return;
 		}
 
-		if (this->info[index].left != 0 && this->info[index].right != 0)
+		if (this->children[index] != 0)
 		{
 			return;
 		}
 
-		// left
-		left.begin = this->info[index].begin;
-		left.end = (this->info[index].begin + this->info[index].end) / 2;
-
-		this->info[index].left = this->info.size();
-		this->info.push_back(left);
-		this->tree.push_back(this->op.identity());
+		this->children[index] = this->children.size();
 
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
+		// left
+		this->_node();
 
 		// right
-		right.begin = left.end + 1;
-		right.end = this->info[index].end;
-
-		this->info[index].right = this->info.size();
-		this->info.push_back(right);
-		this->tree.push_back(this->op.identity());
-
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
+		this->_node();
 	}
 
-	void _push(uint32_t index)
+	void _push(uint32_t index, range_t begin, range_t end)
 		requires(!std::is_empty_v<L>)
 	{
-		if (this->_leaf(index))
+		range_t middle = begin + (end - begin) / 2;
+		uint32_t left = this->children[index];
+
+		if (begin == end)
 		{
 			this->lazy[index] = this->op.reset();
 			return;
 		}
 
-		this->_apply(this->info[index].left, this->lazy[index]);
-		this->_apply(this->info[index].right, this->lazy[index]);
+		this->_apply(left, this->lazy[index], begin, middle);
+		this->_apply(left + 1, this->lazy[index], middle + 1, end);
 
 		this->lazy[index] = this->op.reset();
 	}
 
 	template <typename U>
-	void _build(const vector<U> &elements, const vector<uint32_t> &indices, range_t begin, range_t end)
+	void _build(const vector<U> &elements, const vector<uint32_t> &indices)
 	{
-		// Create the root
-		node root = {};
 		uint32_t count = indices.size();
 
-		root.begin = begin;
-		root.end = end;
-		root.left = 0;
-		root.right = 0;
-
-		this->info.push_back(root);
-		this->tree.push_back(this->op.identity());
-
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
+		// Create the root
+		this->_node();
 
 		for (uint32_t i = 0; i < count; ++i)
 		{
-			this->st.push(0);
+			this->st.push({0, this->begin, this->end});
 
 			while (this->st.size() != 0)
 			{
-				uint32_t index = this->st.top();
-				range_t current_left = this->info[index].begin;
-				range_t current_right = this->info[index].end;
+				auto [index, current_left, current_right] = this->st.top();
+				range_t middle = current_left + (current_right - current_left) / 2;
 
 				this->st.pop();
 
@@ -479,11 +726,11 @@ struct sparse_segment_tree
 				}
 
 				// Create nodes lazily
-				this->_create(index);
+				this->_create(index, current_left, current_right);
 				this->up.push(index);
 
-				this->st.push(this->info[index].left);
-				this->st.push(this->info[index].right);
+				this->st.push({this->children[index], current_left, middle});
+				this->st.push({this->children[index] + 1, middle + 1, current_right});
 			}
 
 			// Join the updated nodes
@@ -506,30 +753,78 @@ struct sparse_segment_tree
 		this->begin = begin;
 		this->end = end;
 
-		this->_build(elements, indices, begin, end);
+		this->_build(elements, indices);
 	}
 
 	template <typename... args>
 	sparse_segment_tree(range_t begin, range_t end, args &&...arg) : op(std::forward<args>(arg)...)
 	{
-		node root = {};
-
 		this->begin = begin;
 		this->end = end;
 
 		// Create the root
-		root.begin = begin;
-		root.end = end;
-		root.left = 0;
-		root.right = 0;
+		this->_node();
+	}
 
-		this->info.push_back(root);
-		this->tree.push_back(this->op.identity());
+	// Preallocate storage for the expected number of nodes.
+	// Each update or query creates at most 2 nodes per level.
+	void reserve(uint32_t count)
+	{
+		this->children.reserve(count);
+		this->tree.reserve(count);
 
 		if constexpr (!std::is_empty_v<L>)
 		{
-			this->lazy.push_back(this->op.reset());
+			this->lazy.reserve(count);
+		}
+	}
+
+	// Renumber the nodes in level order and release unused capacity
+	void compact()
+	{
+		uint32_t count = this->children.size();
+		vector<uint32_t> children(count, 0);
+		vector<uint32_t> order;
+
+		order.reserve(count);
+		order.push_back(0);
+
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			uint32_t left = this->children[order[i]];
+
+			if (left != 0)
+			{
+				children[i] = order.size();
+
+				order.push_back(left);
+				order.push_back(left + 1);
+			}
+		}
+
+		vector<T> tree(order.size());
+
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			tree[i] = std::move(this->tree[order[i]]);
+		}
+
+		if constexpr (!std::is_empty_v<L>)
+		{
+			vector<L> lazy(order.size());
+
+			for (uint32_t i = 0; i < order.size(); ++i)
+			{
+				lazy[i] = std::move(this->lazy[order[i]]);
+			}
+
+			this->lazy = std::move(lazy);
 		}
+
+		children.resize(order.size());
+
+		this->children = std::move(children);
+		this->tree = std::move(tree);
 	}
 
 	T all()
@@ -543,13 +838,12 @@ struct sparse_segment_tree
 	{
 		range_t left = pos, right = pos;
 
-		this->st.push(0);
+		this->st.push({0, this->begin, this->end});
 
 		while (this->st.size() != 0)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, current_left, current_right] = this->st.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			this->st.pop();
 
@@ -560,20 +854,16 @@ struct sparse_segment_tree
 
 			if (current_left >= left && current_right <= right)
 			{
-				// For beats
-				// Determine when all of the nodes are affected
-				// Determine when none of the nodes are affected
-
-				this->tree[index] = this->op.assign(element, index);
+				this->tree[index] = this->op.assign(element, pos);
 				continue;
 			}
 
 			// Create nodes lazily
-			this->_create(index);
+			this->_create(index, current_left, current_right);
 			this->up.push(index);
 
-			this->st.push(this->info[index].left);
-			this->st.push(this->info[index].right);
+			this->st.push({this->children[index], current_left, middle});
+			this->st.push({this->children[index] + 1, middle + 1, current_right});
 		}
 
 		// Join the updated nodes
@@ -597,13 +887,12 @@ struct sparse_segment_tree
 			right = this->end;
 		}
 
-		this->st.push(0);
+		this->st.push({0, this->begin, this->end});
 
 		while (this->st.size() != 0)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, current_left, current_right] = this->st.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			this->st.pop();
 
@@ -618,19 +907,19 @@ struct sparse_segment_tree
 				// Determine when all of the nodes are affected
 				// Determine when none of the nodes are affected
 
-				this->_apply(index, element);
+				this->_apply(index, element, current_left, current_right);
 				continue;
 			}
 
 			// Create nodes lazily
-			this->_create(index);
+			this->_create(index, current_left, current_right);
 
 			// Push the updates lazily
-			this->_push(index);
+			this->_push(index, current_left, current_right);
 			this->up.push(index);
 
-			this->st.push(this->info[index].left);
-			this->st.push(this->info[index].right);
+			this->st.push({this->children[index], current_left, middle});
+			this->st.push({this->children[index] + 1, middle + 1, current_right});
 		}
 
 		// Join the updated nodes
@@ -655,13 +944,12 @@ struct sparse_segment_tree
 			right = this->end;
 		}
 
-		this->st.push(0);
+		this->st.push({0, this->begin, this->end});
 
 		while (this->st.size() != 0)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, current_left, current_right] = this->st.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			this->st.pop();
 
@@ -676,19 +964,27 @@ struct sparse_segment_tree
 				continue;
 			}
 
-			// Create nodes
-			this->_create(index);
-
-			// Push updates
-			if constexpr (!std::is_empty_v<L>)
+			if constexpr (std::is_empty_v<L>)
 			{
-				this->_push(index);
+				// Untouched subtrees hold the identity
+				if (this->children[index] == 0)
+				{
+					continue;
+				}
 			}
+			else
+			{
+				// Create nodes
+				this->_create(index, current_left, current_right);
+
+				// Push updates
+				this->_push(index, current_left, current_right);
+			}
+
+			this->st.push({this->children[index], current_left, middle});
+			this->st.push({this->children[index] + 1, middle + 1, current_right});
+		}
 
-			this->st.push(this->info[index].left);
-			this->st.push(this->info[index].right);
-		}
-
 		return result;
 	}
 };
@@ -699,15 +995,16 @@ struct persistent_segment_tree
 {
 	using range_t = uint32_t;
 
+	// The responsibility of a node is derived on descent.
+	// Ownership is implied by creation order, nodes created by the current operation
+	// (index >= fresh) are referenced only by the node that created them.
 	struct node
 	{
-		range_t begin, end;   // responsibility
-		uint32_t left, right; // children
-		uint32_t parent;
+		uint32_t left, right; // children, 0 if not created
 
 		node()
 		{
-			begin = 0, end = 0, left = 0, right = 0, parent = 0;
+			left = 0, right = 0;
 		}
 	};
 
@@ -715,11 +1012,13 @@ struct persistent_segment_tree
 	vector<T> tree;
 	vector<L> lazy;
 
-	map<uint32_t, uint32_t> roots;
+	vector<uint32_t> roots; // root of each version, UINT32_MAX if absent
+	uint32_t initial;       // root of the initial version (UINT32_MAX)
 	uint32_t recent;
+	uint32_t fresh;
 
-	stack<array<uint32_t, 3>> cm;
-	stack<uint32_t> st;
+	stack<array<uint32_t, 5>> cm;
+	stack<array<uint32_t, 3>> st;
 	stack<uint32_t> up;
 
 	range_t begin;
@@ -729,7 +1028,7 @@ struct persistent_segment_tree
 
 	void _join(uint32_t index)
 	{
-		if (this->_leaf(index))
+		if (this->info[index].left == 0)
 		{
 			return;
 		}
@@ -738,24 +1037,27 @@ struct persistent_segment_tree
 		this->tree[index] = this->op.join(this->tree[this->info[index].left], this->tree[this->info[index].right]);
 	}
 
-	void _apply(uint32_t index, const L &element)
+	void _apply(uint32_t index, const L &element, range_t begin, range_t end)
 		requires(!std::is_empty_v<L>)
 	{
 		// Apply to current node
-		this->tree[index] = this->op.apply(this->tree[index], element, this->info[index].begin, this->info[index].end);
+		this->tree[index] = this->op.apply(this->tree[index], element, begin, end);
 
 		// Push to children
 		this->lazy[index] = this->op.compose(this->lazy[index], element);
 	}
 
-	bool _leaf(uint32_t index)
+	uint32_t _node()
 	{
-		if (this->info[index].begin == this->info[index].end)
+		this->info.push_back({});
+		this->tree.push_back(this->op.identity());
+
+		if constexpr (!std::is_empty_v<L>)
 		{
-			return true;
+			this->lazy.push_back(this->op.reset());
 		}
 
-		return false;
+		return this->info.size() - 1;
 	}
 
 	uint32_t _duplicate(uint32_t index, uint32_t parent, uint32_t lr)
@@ -770,7 +1072,7 @@ struct persistent_segment_tree
 			this->lazy.push_back(this->lazy[index]);
 		}
 
-		if (parent != 0)
+		if (parent != UINT32_MAX)
 		{
 			if (lr == 0)
 			{
@@ -780,8 +1082,6 @@ struct persistent_segment_tree
 			{
 				this->info[parent].right = new_index;
 			}
-
-			this->info[new_index].parent = parent;
 		}
 		else
 		{
@@ -791,11 +1091,11 @@ struct persistent_segment_tree
 		return new_index;
 	}
 
-	void _create(uint32_t index)
+	void _create(uint32_t index, range_t begin, range_t end)
 	{
-		node left = {}, right = {};
+		uint32_t left = 0, right = 0;
 
-		if (this->_leaf(index))
+		if (begin == end)
 		{
 			return;
 		}
@@ -805,108 +1105,94 @@ struct persistent_segment_tree
 			return;
 		}
 
-		// left
-		left.begin = this->info[index].begin;
-		left.end = (this->info[index].begin + this->info[index].end) / 2;
-		left.parent = index;
-
-		this->info[index].left = this->info.size();
-		this->info.push_back(left);
-		this->tree.push_back(this->op.identity());
-
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
-
-		// right
-		right.begin = left.end + 1;
-		right.end = this->info[index].end;
-		right.parent = index;
-
-		this->info[index].right = this->info.size();
-		this->info.push_back(right);
-		this->tree.push_back(this->op.identity());
+		left = this->_node();
+		right = this->_node();
 
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
+		this->info[index].left = left;
+		this->info[index].right = right;
 	}
 
-	void _push(uint32_t index)
+	void _push(uint32_t index, range_t begin, range_t end)
 		requires(!std::is_empty_v<L>)
 	{
-		uint32_t left = this->info[index].left;
-		uint32_t right = this->info[index].right;
+		range_t middle = begin + (end - begin) / 2;
 
-		if (this->_leaf(index))
+		if (begin == end)
 		{
 			this->lazy[index] = this->op.reset();
 			return;
 		}
 
-		if (this->info[left].parent != index)
+		// Children shared with other versions are copied before the update
+		if (this->info[index].left < this->fresh)
 		{
-			this->_duplicate(left, index, 0);
+			this->_duplicate(this->info[index].left, index, 0);
 		}
 
-		if (this->info[right].parent != index)
+		if (this->info[index].right < this->fresh)
 		{
-			this->_duplicate(right, index, 1);
+			this->_duplicate(this->info[index].right, index, 1);
 		}
 
-		this->_apply(this->info[index].left, this->lazy[index]);
-		this->_apply(this->info[index].right, this->lazy[index]);
+		this->_apply(this->info[index].left, this->lazy[index], begin, middle);
+		this->_apply(this->info[index].right, this->lazy[index], middle + 1, end);
 
 		this->lazy[index] = this->op.reset();
 	}
 
-	void _sentinel()
+	uint32_t _root(uint32_t version)
 	{
-		node sentinel = {};
+		if (version < this->roots.size() && this->roots[version] != UINT32_MAX)
+		{
+			return this->roots[version];
+		}
 
-		sentinel.begin = begin;
-		sentinel.end = end;
+		return this->initial;
+	}
 
-		this->info.push_back(sentinel);
-		this->tree.push_back(this->op.identity());
-		this->roots.insert({UINT32_MAX, 0});
+	bool _contains(uint32_t version)
+	{
+		if (version == UINT32_MAX)
+		{
+			return true;
+		}
 
-		if constexpr (!std::is_empty_v<L>)
+		return version < this->roots.size() && this->roots[version] != UINT32_MAX;
+	}
+
+	void _assign(uint32_t version, uint32_t index)
+	{
+		if (version == UINT32_MAX)
 		{
-			this->lazy.push_back(this->op.reset());
+			this->initial = index;
+			return;
+		}
+
+		if (version >= this->roots.size())
+		{
+			this->roots.resize(version + 1, UINT32_MAX);
 		}
+
+		this->roots[version] = index;
 	}
 
 	template <typename U>
-	void _build(const vector<U> &elements, const vector<uint32_t> &indices, range_t begin, range_t end)
+	void _build(const vector<U> &elements, const vector<uint32_t> &indices)
 	{
-		// Create the root
-		node root = {};
 		uint32_t count = indices.size();
 
-		root.begin = begin;
-		root.end = end;
-
-		this->info.push_back(root);
-		this->tree.push_back(this->op.identity());
-		this->roots.insert({UINT32_MAX, 0});
-
-		if constexpr (!std::is_empty_v<L>)
-		{
-			this->lazy.push_back(this->op.reset());
-		}
+		// Create the root
+		this->initial = this->_node();
+		this->fresh = 0;
 
 		for (uint32_t i = 0; i < count; ++i)
 		{
-			this->st.push(0);
+			this->st.push({this->initial, this->begin, this->end});
 
 			while (this->st.size() != 0)
 			{
-				uint32_t index = this->st.top();
-				range_t current_left = this->info[index].begin;
-				range_t current_right = this->info[index].end;
+				auto [index, current_left, current_right] = this->st.top();
+				range_t middle = current_left + (current_right - current_left) / 2;
 
 				this->st.pop();
 
@@ -922,11 +1208,11 @@ struct persistent_segment_tree
 				}
 
 				// Create nodes lazily
-				this->_create(index);
+				this->_create(index, current_left, current_right);
 				this->up.push(index);
 
-				this->st.push(this->info[index].left);
-				this->st.push(this->info[index].right);
+				this->st.push({this->info[index].left, current_left, middle});
+				this->st.push({this->info[index].right, middle + 1, current_right});
 			}
 
 			// Join the updated nodes
@@ -949,7 +1235,7 @@ struct persistent_segment_tree
 		this->begin = begin;
 		this->end = end;
 
-		this->_build(elements, indices, begin, end);
+		this->_build(elements, indices);
 	}
 
 	template <typename U, typename... args>
@@ -965,7 +1251,7 @@ struct persistent_segment_tree
 			indices[i] = i;
 		}
 
-		this->_build(elements, indices, this->begin, this->end);
+		this->_build(elements, indices);
 	}
 
 	template <typename... args>
@@ -974,34 +1260,118 @@ struct persistent_segment_tree
 		this->begin = begin;
 		this->end = end;
 
-		this->_sentinel();
+		this->initial = this->_node();
 	}
 
 	T all(uint32_t base)
 	{
-		if (!this->roots.contains(base))
+		if (!this->_contains(base))
 		{
 			return this->op.identity();
 		}
 
-		return this->tree[this->roots[base]];
+		return this->tree[this->_root(base)];
 	}
 
 	void copy(uint32_t base, uint32_t update)
 	{
-		uint32_t index = 0;
+		this->fresh = this->info.size();
+		this->_assign(update, this->_duplicate(this->_root(base), UINT32_MAX, 0));
+	}
 
-		if (this->roots.contains(base))
+	// Drop a version, its nodes are reclaimed by the next collect
+	void release(uint32_t version)
+	{
+		if (version < this->roots.size())
 		{
-			index = this->roots[base];
+			this->roots[version] = UINT32_MAX;
 		}
-		else
+	}
+
+	// Reclaim the nodes unreachable from the live versions
+	void collect()
+	{
+		vector<uint32_t> remap(this->info.size(), UINT32_MAX);
+		vector<uint32_t> order;
+
+		auto mark = [&](uint32_t root)
+		{
+			if (remap[root] != UINT32_MAX)
+			{
+				return;
+			}
+
+			remap[root] = order.size();
+			order.push_back(root);
+
+			for (uint32_t i = order.size() - 1; i < order.size(); ++i)
+			{
+				for (uint32_t child : {this->info[order[i]].left, this->info[order[i]].right})
+				{
+					if (child != 0 && remap[child] == UINT32_MAX)
+					{
+						remap[child] = order.size();
+						order.push_back(child);
+					}
+				}
+			}
+		};
+
+		mark(this->initial);
+
+		for (uint32_t root : this->roots)
 		{
-			index = this->roots[UINT32_MAX];
+			if (root != UINT32_MAX)
+			{
+				mark(root);
+			}
 		}
 
-		index = this->_duplicate(index, 0, 0);
-		this->roots.insert({update, index});
+		vector<node> info(order.size());
+		vector<T> tree(order.size());
+
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			info[i] = this->info[order[i]];
+			tree[i] = std::move(this->tree[order[i]]);
+
+			if (info[i].left != 0)
+			{
+				info[i].left = remap[info[i].left];
+				info[i].right = remap[info[i].right];
+			}
+		}
+
+		if constexpr (!std::is_empty_v<L>)
+		{
+			vector<L> lazy(order.size());
+
+			for (uint32_t i = 0; i < order.size(); ++i)
+			{
+				lazy[i] = std::move(this->lazy[order[i]]);
+			}
+
+			this->lazy = std::move(lazy);
+		}
+
+		this->info = std::move(info);
+		this->tree = std::move(tree);
+
+		this->initial = remap[this->initial];
+
+		for (uint32_t &root : this->roots)
+		{
+			if (root != UINT32_MAX)
+			{
+				root = remap[root];
+			}
+		}
+
+		// Trailing dropped versions
+		while (this->roots.size() != 0 && this->roots.back() == UINT32_MAX)
+		{
+			this->roots.pop_back();
+		}
 	}
 
 	template <typename U>
@@ -1010,20 +1380,14 @@ struct persistent_segment_tree
 	{
 		range_t left = pos, right = pos;
 
-		if (this->roots.contains(base))
-		{
-			this->cm.push({this->roots[base], 0, 0});
-		}
-		else
-		{
-			this->cm.push({this->roots[UINT32_MAX], 0, 0});
-		}
+		this->fresh = this->info.size();
+		this->recent = this->_root(base);
+		this->cm.push({this->recent, UINT32_MAX, 0, this->begin, this->end});
 
 		while (this->cm.size() != 0)
 		{
-			auto [index, parent, lr] = this->cm.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, parent, lr, current_left, current_right] = this->cm.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			uint32_t new_index = 0;
 
@@ -1036,24 +1400,20 @@ struct persistent_segment_tree
 
 			if (current_left >= left && current_right <= right)
 			{
-				// For beats
-				// Determine when all of the nodes are affected
-				// Determine when none of the nodes are affected
-
 				new_index = this->_duplicate(index, parent, lr);
-				this->tree[new_index] = this->op.assign(element, new_index);
+				this->tree[new_index] = this->op.assign(element, pos);
 
 				continue;
 			}
 
 			// Create nodes lazily
-			this->_create(index);
+			this->_create(index, current_left, current_right);
 
 			// Create new nodes for updated path
 			this->up.push(new_index = this->_duplicate(index, parent, lr));
 
-			this->cm.push({this->info[new_index].left, new_index, 0});
-			this->cm.push({this->info[new_index].right, new_index, 1});
+			this->cm.push({this->info[new_index].left, new_index, 0, current_left, middle});
+			this->cm.push({this->info[new_index].right, new_index, 1, middle + 1, current_right});
 		}
 
 		// Join the updated nodes
@@ -1064,7 +1424,7 @@ struct persistent_segment_tree
 		}
 
 		// Add new root
-		this->roots[update] = this->recent;
+		this->_assign(update, this->recent);
 	}
 
 	void update(uint32_t base, uint32_t update, range_t left, range_t right, const L &element)
@@ -1080,20 +1440,14 @@ struct persistent_segment_tree
 			right = this->end;
 		}
 
-		if (this->roots.contains(base))
-		{
-			this->cm.push({this->roots[base], 0, 0});
-		}
-		else
-		{
-			this->cm.push({this->roots[UINT32_MAX], 0, 0});
-		}
+		this->fresh = this->info.size();
+		this->recent = this->_root(base);
+		this->cm.push({this->recent, UINT32_MAX, 0, this->begin, this->end});
 
 		while (this->cm.size() != 0)
 		{
-			auto [index, parent, lr] = this->cm.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, parent, lr, current_left, current_right] = this->cm.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			uint32_t new_index = 0;
 
@@ -1110,21 +1464,21 @@ struct persistent_segment_tree
 				// Determine when all of the nodes are affected
 				// Determine when none of the nodes are affected
 
-				this->_apply(this->_duplicate(index, parent, lr), element);
+				this->_apply(this->_duplicate(index, parent, lr), element, current_left, current_right);
 				continue;
 			}
 
 			// Create nodes lazily
-			this->_create(index);
+			this->_create(index, current_left, current_right);
 
 			// Push the updates lazily
-			this->_push(index);
+			this->_push(index, current_left, current_right);
 
 			// Create new nodes for updated path
 			this->up.push(new_index = this->_duplicate(index, parent, lr));
 
-			this->cm.push({this->info[new_index].left, new_index, 0});
-			this->cm.push({this->info[new_index].right, new_index, 1});
+			this->cm.push({this->info[new_index].left, new_index, 0, current_left, middle});
+			this->cm.push({this->info[new_index].right, new_index, 1, middle + 1, current_right});
 		}
 
 		// Join the updated nodes
@@ -1135,7 +1489,7 @@ struct persistent_segment_tree
 		}
 
 		// Add new root
-		this->roots[update] = this->recent;
+		this->_assign(update, this->recent);
 	}
 
 	T query(uint32_t base, range_t left, range_t right)
@@ -1152,20 +1506,13 @@ struct persistent_segment_tree
 			right = this->end;
 		}
 
-		if (this->roots.contains(base))
-		{
-			this->st.push(this->roots[base]);
-		}
-		else
-		{
-			this->st.push(this->roots[UINT32_MAX]);
-		}
+		this->fresh = this->info.size();
+		this->st.push({this->_root(base), this->begin, this->end});
 
 		while (this->st.size() != 0)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->info[index].begin;
-			range_t current_right = this->info[index].end;
+			auto [index, current_left, current_right] = this->st.top();
+			range_t middle = current_left + (current_right - current_left) / 2;
 
 			this->st.pop();
 
@@ -1180,500 +1527,349 @@ struct persistent_segment_tree
 				continue;
 			}
 
-			// Create nodes
-			this->_create(index);
-
-			// Push updates
-			if constexpr (!std::is_empty_v<L>)
+			if constexpr (std::is_empty_v<L>)
 			{
-				this->_push(index);
+				// Untouched subtrees hold the identity
+				if (this->info[index].left == 0)
+				{
+					continue;
+				}
 			}
+			else
+			{
+				// Create nodes
+				this->_create(index, current_left, current_right);
 
-			this->st.push(this->info[index].left);
-			this->st.push(this->info[index].right);
+				// Push updates
+				this->_push(index, current_left, current_right);
+			}
+
+			this->st.push({this->info[index].left, current_left, middle});
+			this->st.push({this->info[index].right, middle + 1, current_right});
 		}
 
 		return result;
 	}
 };
 
+// Point update, rectangle query over a dense grid
+// Rows and columns are joined independently, so the operator should be commutative
+template <typename T, typename O>
+	requires segtree_operator<O, T>
 struct segment_tree_2d
 {
-	using range_t = uint32_t;
-
-	struct segment_tree_node
-	{
-		struct node
-		{
-			range_t begin, end;   // responsibility
-			uint32_t left, right; // children
-
-			node()
-			{
-				begin = 0, end = 0, left = 0, right = 0;
-			}
-		};
+	// Bottom up in both dimensions, (2n x 2m) nodes
+	vector<T> tree;
 
-		struct update
-		{
-		};
+	uint32_t n;
+	uint32_t m;
 
-		vector<node> tree;
-		vector<update> lazy;
+	O op;
 
-		stack<uint32_t> st;
-		stack<uint32_t> up;
+	T &_at(uint32_t x, uint32_t y)
+	{
+		return this->tree[(x * (this->m * 2)) + y];
+	}
 
-		range_t begin, end;
-		range_t pbegin, pend;
+	T _query(uint32_t x, uint32_t left, uint32_t right)
+	{
+		T result = this->op.identity();
 
-		void _join(uint32_t index)
+		for (left += this->m, right += this->m + 1; left < right; left >>= 1, right >>= 1)
 		{
-			uint32_t left = this->tree[index].left;
-			uint32_t right = this->tree[index].right;
-
-			if (this->_leaf(index))
+			if (left & 1)
 			{
-				return;
+				result = this->op.join(result, this->_at(x, left++));
 			}
 
-			// Join here
-		}
-
-		void _apply(uint32_t index, const update &element)
-		{
-			// Apply to current node
-
-			// Push to children
+			if (right & 1)
+			{
+				result = this->op.join(this->_at(x, --right), result);
+			}
 		}
 
-		bool _skip(uint32_t index)
-		{
-			// Condition for skipping push
-			return false;
-		}
+		return result;
+	}
 
-		bool _leaf(uint32_t index)
-		{
-			if (this->tree[index].begin == this->tree[index].end)
-			{
-				return true;
-			}
+	template <typename U>
+	void _build(const vector<vector<U>> &elements)
+	{
+		this->n = elements.size();
+		this->m = this->n != 0 ? elements[0].size() : 0;
 
-			return false;
-		}
+		this->tree = vector<T>(4 * this->n * this->m, this->op.identity());
 
-		void _create(uint32_t index)
+		for (uint32_t i = 0; i < this->n; ++i)
 		{
-			node left = {}, right = {};
-
-			if (this->_leaf(index))
+			for (uint32_t j = 0; j < this->m; ++j)
 			{
-				return;
+				this->_at(i + this->n, j + this->m) = this->op.assign(elements[i][j], (i * this->m) + j);
 			}
 
-			if (this->tree[index].left != 0 && this->tree[index].right != 0)
+			for (uint32_t j = this->m; j > 1; --j)
 			{
-				return;
+				this->_at(i + this->n, j - 1) = this->op.join(this->_at(i + this->n, (j - 1) * 2), this->_at(i + this->n, ((j - 1) * 2) + 1));
 			}
-
-			// left
-			left.begin = this->tree[index].begin;
-			left.end = (this->tree[index].begin + this->tree[index].end) / 2;
-
-			this->tree[index].left = this->tree.size();
-			this->tree.push_back(left);
-			this->lazy.push_back({});
-
-			// right
-			right.begin = left.end + 1;
-			right.end = this->tree[index].end;
-
-			this->tree[index].right = this->tree.size();
-			this->tree.push_back(right);
-			this->lazy.push_back({});
 		}
 
-		void _push(uint32_t index)
+		for (uint32_t i = this->n; i > 1; --i)
 		{
-			if (this->_leaf(index))
+			for (uint32_t j = 1; j < this->m * 2; ++j)
 			{
-				this->lazy[index] = {};
-				return;
+				this->_at(i - 1, j) = this->op.join(this->_at((i - 1) * 2, j), this->_at(((i - 1) * 2) + 1, j));
 			}
+		}
+	}
 
-			if (this->_skip(index))
-			{
-				return;
-			}
+	segment_tree_2d()
+	{
+	}
 
-			this->_apply(this->tree[index].left, this->lazy[index]);
-			this->_apply(this->tree[index].right, this->lazy[index]);
+	template <typename U, typename... args>
+	segment_tree_2d(const vector<vector<U>> &elements, args &&...arg) : op(std::forward<args>(arg)...)
+	{
+		this->_build(elements);
+	}
 
-			this->lazy[index] = {};
-		}
+	template <typename U>
+	void update(uint32_t x, uint32_t y, const U &element)
+	{
+		uint32_t row = x + this->n;
+		uint32_t column = y + this->m;
 
-		void _build(range_t begin, range_t end)
+		if (x >= this->n || y >= this->m)
 		{
-			// Create the root
-			node root;
-
-			root.begin = begin;
-			root.end = end;
-			root.left = 0;
-			root.right = 0;
-
-			this->tree.push_back(root);
-			this->lazy.push_back({});
+			return;
 		}
 
-		segment_tree_node(range_t pbegin, range_t pend, range_t begin, range_t end)
-		{
-			this->begin = begin;
-			this->end = end;
-			this->pbegin = pbegin;
-			this->pend = pend;
+		this->_at(row, column) = this->op.assign(element, (x * this->m) + y);
 
-			this->_build(begin, end);
+		for (uint32_t j = column >> 1; j != 0; j >>= 1)
+		{
+			this->_at(row, j) = this->op.join(this->_at(row, j * 2), this->_at(row, (j * 2) + 1));
 		}
 
-		void range_update(range_t left, range_t right)
+		for (uint32_t i = row >> 1; i != 0; i >>= 1)
 		{
-			if (left > this->end)
+			for (uint32_t j = column; j != 0; j >>= 1)
 			{
-				left = this->begin;
+				this->_at(i, j) = this->op.join(this->_at(i * 2, j), this->_at((i * 2) + 1, j));
 			}
+		}
+	}
 
-			if (right > this->end)
-			{
-				right = this->end;
-			}
-
-			this->st.push(0);
-
-			while (this->st.size() != 0)
-			{
-				uint32_t index = this->st.top();
-				range_t current_left = this->tree[index].begin;
-				range_t current_right = this->tree[index].end;
-
-				this->st.pop();
-
-				if (current_right < left || current_left > right)
-				{
-					continue;
-				}
-
-				if (current_left >= left && current_right <= right)
-				{
-					// For beats
-					// Determine when all of the nodes are affected
-					// Determine when none of the nodes are affected
-
-					this->_apply(index, {});
-					continue;
-				}
-
-				// Create nodes lazily
-				this->_create(index);
-
-				// Push the updates lazily
-				this->_push(index);
-				this->up.push(index);
-
-				this->st.push(this->tree[index].left);
-				this->st.push(this->tree[index].right);
-			}
+	// (top, left) -> (bottom, right) inclusive
+	T query(uint32_t top, uint32_t left, uint32_t bottom, uint32_t right)
+	{
+		T result = this->op.identity();
 
-			// Join the updated nodes
-			while (this->up.size() != 0)
-			{
-				this->_join(this->up.top());
-				this->up.pop();
-			}
+		if (bottom >= this->n)
+		{
+			bottom = this->n - 1;
 		}
 
-		uint32_t range_query(range_t left, range_t right)
+		if (right >= this->m)
 		{
-			uint32_t result = 0;
+			right = this->m - 1;
+		}
 
-			if (left > this->end)
-			{
-				left = this->begin;
-			}
+		if (top > bottom || left > right)
+		{
+			return result;
+		}
 
-			if (right > this->end)
+		for (top += this->n, bottom += this->n + 1; top < bottom; top >>= 1, bottom >>= 1)
+		{
+			if (top & 1)
 			{
-				right = this->end;
+				result = this->op.join(result, this->_query(top++, left, right));
 			}
 
-			this->st.push(0);
-
-			while (this->st.size() != 0)
+			if (bottom & 1)
 			{
-				uint32_t index = this->st.top();
-				range_t current_left = this->tree[index].begin;
-				range_t current_right = this->tree[index].end;
-
-				this->st.pop();
-
-				if (current_right < left || current_left > right)
-				{
-					continue;
-				}
-
-				if (current_left >= left && current_right <= right)
-				{
-
-					continue;
-				}
-
-				// Create nodes
-				this->_create(index);
-
-				// Push updates
-				this->_push(index);
-
-				this->st.push(this->tree[index].left);
-				this->st.push(this->tree[index].right);
+				result = this->op.join(this->_query(--bottom, left, right), result);
 			}
-
-			return result;
 		}
-	};
 
-	struct node
-	{
-		segment_tree_node element;
-		range_t begin, end;   // responsibility
-		uint32_t left, right; // children
-
-		node(range_t begin, range_t end, range_t sbegin, range_t send) : element(begin, end, sbegin, send)
-		{
-			begin = 0, end = 0, left = 0, right = 0;
-		}
-	};
+		return result;
+	}
+};
 
-	struct update
-	{
-		uint64_t value;
-		range_t begin, end;
-	};
+// Point update, rectangle query over a fixed set of points with arbitrary coordinates
+// Each x node keeps the sorted y coordinates in its range with a tree over them
+// Rows and columns are joined independently, so the operator should be commutative
+template <typename T, typename O>
+	requires segtree_operator<O, T>
+struct sparse_segment_tree_2d
+{
+	using range_t = uint32_t;
 
-	vector<node> tree;
-	vector<vector<update>> lazy;
+	vector<range_t> xs;          // distinct x coordinates
+	vector<vector<range_t>> ys;  // distinct y coordinates of each x node
+	vector<vector<T>> tree;      // bottom up tree over ys of each x node
+	vector<uint32_t> offsets;    // points before each distinct x
 
-	stack<uint32_t> st;
+	uint32_t n;
 
-	range_t x_begin, x_end;
-	range_t y_begin, y_end;
+	O op;
 
-	void _apply(uint32_t index, const update &element)
+	uint32_t _find(const vector<range_t> &coordinates, range_t value)
 	{
-		// Apply to current node
-		this->tree[index].element.range_update(element.begin, element.end);
+		uint32_t index = lower_bound(coordinates.begin(), coordinates.end(), value) - coordinates.begin();
 
-		// Push to children
-		this->lazy[index].push_back(element);
-	}
-
-	bool _skip(uint32_t index)
-	{
-		// Condition for skipping push
-		if (this->lazy[index].size() == 0)
+		if (index == coordinates.size() || coordinates[index] != value)
 		{
-			return true;
+			return UINT32_MAX;
 		}
 
-		return false;
+		return index;
 	}
 
-	bool _leaf(uint32_t index)
+	T _get(uint32_t x, range_t y)
 	{
-		if (this->tree[index].begin == this->tree[index].end)
+		uint32_t index = this->_find(this->ys[x], y);
+
+		if (index == UINT32_MAX)
 		{
-			return true;
+			return this->op.identity();
 		}
 
-		return false;
+		return this->tree[x][index + this->ys[x].size()];
 	}
 
-	void _create(uint32_t index)
+	void _set(uint32_t x, uint32_t index, const T &value)
 	{
-		uint32_t begin = 0, end = 0;
+		vector<T> &inner = this->tree[x];
 
-		if (this->_leaf(index))
-		{
-			return;
-		}
+		index += this->ys[x].size();
+		inner[index] = value;
 
-		if (this->tree[index].left != 0 && this->tree[index].right != 0)
+		for (index >>= 1; index != 0; index >>= 1)
 		{
-			return;
+			inner[index] = this->op.join(inner[index * 2], inner[(index * 2) + 1]);
 		}
-
-		// left
-		begin = this->tree[index].begin;
-		end = (this->tree[index].begin + this->tree[index].end) / 2;
-
-		node left = node(begin, end, this->y_begin, this->y_end);
-		left.begin = begin;
-		left.end = end;
-
-		this->tree[index].left = this->tree.size();
-		this->tree.push_back(left);
-		this->lazy.push_back({});
-
-		// right
-		begin = end + 1;
-		end = this->tree[index].end;
-
-		node right = node(begin, end, this->y_begin, this->y_end);
-		right.begin = begin;
-		right.end = end;
-
-		this->tree[index].right = this->tree.size();
-		this->tree.push_back(right);
-		this->lazy.push_back({});
 	}
 
-	void _push(uint32_t index)
+	T _query(uint32_t x, range_t low, range_t high)
 	{
-		if (this->_leaf(index))
-		{
-			this->lazy[index].clear();
-			return;
-		}
+		const vector<range_t> &coordinates = this->ys[x];
+		T result = this->op.identity();
 
-		if (this->_skip(index))
-		{
-			return;
-		}
+		uint32_t size = coordinates.size();
+		uint32_t left = lower_bound(coordinates.begin(), coordinates.end(), low) - coordinates.begin();
+		uint32_t right = upper_bound(coordinates.begin(), coordinates.end(), high) - coordinates.begin();
 
-		for (uint32_t i = 0; i < this->lazy[index].size(); ++i)
+		for (left += size, right += size; left < right; left >>= 1, right >>= 1)
 		{
-			this->_apply(this->tree[index].left, this->lazy[index][i]);
-			this->_apply(this->tree[index].right, this->lazy[index][i]);
+			if (left & 1)
+			{
+				result = this->op.join(result, this->tree[x][left++]);
+			}
+
+			if (right & 1)
+			{
+				result = this->op.join(this->tree[x][--right], result);
+			}
 		}
 
-		this->lazy[index].clear();
+		return result;
 	}
 
-	void _build(range_t x_begin, range_t x_end, range_t y_begin, range_t y_end)
+	sparse_segment_tree_2d()
 	{
-		// Create the root
-		node root = node(x_begin, x_end, y_begin, y_end);
-
-		root.begin = x_begin;
-		root.end = x_end;
-		root.left = 0;
-		root.right = 0;
-
-		this->tree.push_back(root);
-		this->lazy.push_back({});
 	}
 
-	segment_tree_2d(range_t x_begin, range_t x_end, range_t y_begin, range_t y_end)
-	{
-		this->x_begin = x_begin;
-		this->x_end = y_end;
-		this->y_begin = y_begin;
-		this->y_end = y_end;
-
-		this->_build(x_begin, x_end, y_begin, y_end);
-	}
-
-	void range_update(range_t x_left, range_t x_right, range_t y_left, range_t y_right)
+	// All points that will ever be updated must be known upfront
+	template <typename... args>
+	sparse_segment_tree_2d(const vector<pair<range_t, range_t>> &points, args &&...arg) : op(std::forward<args>(arg)...)
 	{
-		if (x_left > this->x_end)
+		for (const auto &[x, y] : points)
 		{
-			x_left = this->x_begin;
+			this->xs.push_back(x);
 		}
 
-		if (x_right > this->x_end)
-		{
-			x_right = this->x_end;
-		}
+		sort(this->xs.begin(), this->xs.end());
+		this->xs.erase(unique(this->xs.begin(), this->xs.end()), this->xs.end());
 
-		this->st.push(0);
+		this->n = this->xs.size();
+		this->ys = vector<vector<range_t>>(this->n * 2);
+		this->tree = vector<vector<T>>(this->n * 2);
 
-		while (this->st.size() != 0)
+		for (const auto &[x, y] : points)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->tree[index].begin;
-			range_t current_right = this->tree[index].end;
-
-			this->st.pop();
+			this->ys[this->_find(this->xs, x) + this->n].push_back(y);
+		}
 
-			if (current_right < x_left || current_left > x_right)
-			{
-				continue;
-			}
+		this->offsets = vector<uint32_t>(this->n + 1, 0);
 
-			if (current_left >= x_left && current_right <= x_right)
-			{
-				// For beats
-				// Determine when all of the nodes are affected
-				// Determine when none of the nodes are affected
-
-				this->_apply(index, {y_left, y_right, 0});
-				continue;
-			}
+		for (uint32_t i = this->n; i < this->n * 2; ++i)
+		{
+			sort(this->ys[i].begin(), this->ys[i].end());
+			this->ys[i].erase(unique(this->ys[i].begin(), this->ys[i].end()), this->ys[i].end());
+			this->offsets[i - this->n + 1] = this->offsets[i - this->n] + this->ys[i].size();
+		}
 
-			// Create nodes lazily
-			this->_create(index);
+		for (uint32_t i = this->n; i > 1; --i)
+		{
+			const vector<range_t> &left = this->ys[(i - 1) * 2];
+			const vector<range_t> &right = this->ys[((i - 1) * 2) + 1];
 
-			// Push the updates lazily
-			this->_push(index);
+			set_union(left.begin(), left.end(), right.begin(), right.end(), back_inserter(this->ys[i - 1]));
+		}
 
-			this->st.push(this->tree[index].left);
-			this->st.push(this->tree[index].right);
+		for (uint32_t i = 1; i < this->n * 2; ++i)
+		{
+			this->tree[i] = vector<T>(this->ys[i].size() * 2, this->op.identity());
 		}
 	}
 
-	uint32_t range_query(range_t x_left, range_t x_right, range_t y_left, range_t y_right)
+	template <typename U>
+	void update(range_t x, range_t y, const U &element)
 	{
-		uint32_t result = 0;
+		uint32_t index = this->_find(this->xs, x);
+		uint32_t position = 0;
 
-		if (x_left > this->x_end)
+		if (index == UINT32_MAX)
 		{
-			x_left = this->x_begin;
+			return;
 		}
 
-		if (x_right > this->x_end)
+		index += this->n;
+		position = this->_find(this->ys[index], y);
+
+		if (position == UINT32_MAX)
 		{
-			x_right = this->x_end;
+			return;
 		}
 
-		this->st.push(0);
+		// Row major rank of the point, the compressed analogue of x * m + y
+		this->_set(index, position, this->op.assign(element, this->offsets[index - this->n] + position));
 
-		while (this->st.size() != 0)
+		for (index >>= 1; index != 0; index >>= 1)
 		{
-			uint32_t index = this->st.top();
-			range_t current_left = this->tree[index].begin;
-			range_t current_right = this->tree[index].end;
+			this->_set(index, this->_find(this->ys[index], y), this->op.join(this->_get(index * 2, y), this->_get((index * 2) + 1, y)));
+		}
+	}
 
-			this->st.pop();
+	// (top, left) -> (bottom, right) inclusive, x is the row and y is the column
+	T query(range_t top, range_t left, range_t bottom, range_t right)
+	{
+		T result = this->op.identity();
+
+		uint32_t begin = lower_bound(this->xs.begin(), this->xs.end(), top) - this->xs.begin();
+		uint32_t end = upper_bound(this->xs.begin(), this->xs.end(), bottom) - this->xs.begin();
 
-			if (current_right < x_left || current_left > x_right)
+		for (begin += this->n, end += this->n; begin < end; begin >>= 1, end >>= 1)
+		{
+			if (begin & 1)
 			{
-				continue;
+				result = this->op.join(result, this->_query(begin++, left, right));
 			}
 
-			if (current_left >= x_left && current_right <= x_right)
+			if (end & 1)
 			{
-				result += this->tree[index].element.range_query(y_left, y_right);
-				continue;
+				result = this->op.join(this->_query(--end, left, right), result);
 			}
-
-			// Create nodes
-			this->_create(index);
-
-			// Push updates
-			this->_push(index);
-
-			this->st.push(this->tree[index].left);
-			this->st.push(this->tree[index].right);
 		}
 
 		return result;
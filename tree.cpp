@@ -201,7 +201,7 @@ struct lowest_common_ancestor
 
 		for (uint32_t i = 0; i < this->vertex_count; ++i)
 		{
-			cin >> this->vertices[i].placeholder;
+			input(this->vertices[i].placeholder);
 		}
 	}
 
@@ -217,7 +217,7 @@ struct lowest_common_ancestor
 
 		for (uint32_t i = 0; i < this->edge_count; ++i)
 		{
-			cin >> this->edges[i].source >> this->edges[i].destination;
+			input(this->edges[i].source, this->edges[i].destination);
 
 			this->edges[i].source--;
 			this->edges[i].destination--;